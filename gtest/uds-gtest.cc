@@ -25,18 +25,16 @@ UDS_SERVER g_stUdsServer;
 #define TEST_CLIENT_COUNT   5                    ///< 테스트 클라이언트 수
 #define CONNECT_WAIT_MS     80             ///< 클라이언트 연결 대기 시간(ms)
 #define DATA_WAIT_MS        300               ///< 데이터 수신 대기 시간(ms)
+#define TEST_DGRAM_PATH     "/tmp/test_dgram_socket" ///< 테스트용 데이터그램 소켓 경로
 
 /**
  * @brief 테스트용 UDS 서버 초기화 함수
  *
  * 서버 소켓을 생성하고, 클라이언트 배열 및 뮤텍스를 초기화합니다.
- * 연결 관리, 송수신 스레드를 시작합니다.
+ * 연결 관리, 송수신 스레드는 서버가 직접 시작합니다.
  */
 void startUds() {    
     startUdsServer(&g_stUdsServer, TEST_SOCKET_PATH, TEST_CLIENT_COUNT);
-    std::thread(&connectionManagerThread, &g_stUdsServer).detach();
-    std::thread(&sendThread, &g_stUdsServer).detach();
-    std::thread(&recvThread, &g_stUdsServer).detach();
 }
 
 /**
@@ -254,12 +252,17 @@ TEST_F(UdsServerTest, FragmentedSendTest) {
     send(sock, part2, strlen(part2), 0);
 
     std::this_thread::sleep_for(std::chrono::milliseconds(DATA_WAIT_MS));
+    // 수신 스레드가 새 클라이언트를 즉시 감시하므로 두 부분이 별도 항목으로 들어올 수 있다
+    std::string msg;
     void* data = nullptr;
-    int size = queuePop(&g_stUdsServer.pstClients[0].stRecvQueue, &data);
-    ASSERT_GT(size, 0);
-    std::string msg((char*)data, size);
-    free(data);
+    int size;
+    while ((size = queuePop(&g_stUdsServer.pstClients[0].stRecvQueue, &data)) > 0 && data) {
+        msg.append((char*)data, size);
+        free(data);
+    }
+    ASSERT_GT(msg.size(), 0u);
 
+    EXPECT_EQ(msg, std::string(part1) + part2);
     EXPECT_TRUE(msg.find("Part1_") != std::string::npos);
     EXPECT_TRUE(msg.find("Part2_END") != std::string::npos);
 }
@@ -343,6 +346,733 @@ TEST_F(UdsServerTest, ClientReconnectTest) {
     free(data);
     ASSERT_EQ(recvData, msg);
 }
+
+/**
+ * @test CoalescedSendTest
+ * @brief 송신 병합 모드 테스트
+ *
+ * 병합 모드를 설정한 클라이언트에 작은 메시지 여러 개를 push하고,
+ * 지연 시간 안에 쌓인 메시지들이 한 번의 전송으로 도착하는지 확인합니다.
+ * 송신 스레드가 쉬고 있을 때 넣은 메시지도 넣은 시각부터 지연 시간이 지나면 도착해야 합니다.
+ */
+TEST_F(UdsServerTest, CoalescedSendTest) {
+    int sock = createTestClientSocket();
+    ASSERT_GT(sock, 0);
+    clientSockets.push_back(sock);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_EQ(setUdsClientCoalescing(&g_stUdsServer, 0, 4096, 50*1000), 0);
+
+    std::string expected;
+    for (int i = 0; i < 5; ++i) {
+        std::string msg = "Coalesce_" + std::to_string(i) + ";";
+        expected += msg;
+        char* data = strdup(msg.c_str());
+        queuePush(&g_stUdsServer.pstClients[0].stSendQueue, data, msg.size());
+    }
+
+    char buf[256] = {0};
+    int len = udsRecvMsgTimeout(sock, buf, sizeof(buf), 500);
+    ASSERT_GT(len, 0);
+    EXPECT_EQ(std::string(buf, len), expected);
+
+    const int delayUsec = 10 * 1000;
+    const int rounds = 10;
+    ASSERT_EQ(setUdsClientCoalescing(&g_stUdsServer, 0, 4096, delayUsec), 0);
+    long long totalUsec = 0;
+    for (int i = 0; i < rounds; ++i) {
+        // 송신 스레드의 유휴 주기와 어긋나도록 쉬는 시간을 조금씩 바꾼다
+        std::this_thread::sleep_for(std::chrono::milliseconds(20 + i));
+        char* data = strdup("Late;");
+        auto start = std::chrono::steady_clock::now();
+        ASSERT_EQ(udsServerQueueSend(&g_stUdsServer, 0, data, 5), 0);
+        ASSERT_EQ(udsRecvMsgTimeout(sock, buf, sizeof(buf), 500), 5);
+        totalUsec += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    EXPECT_LT(totalUsec / rounds, delayUsec + 1500);
+}
+
+/**
+ * @test DgramEndpointTest
+ * @brief 데이터그램 엔드포인트 수신 테스트
+ *
+ * 연결 없이 데이터그램을 여러 개 전송하고, udsServerRecvDgram()으로
+ * 메시지와 송신자 자격 증명(PID)을 올바르게 받는지 확인합니다.
+ * 데이터그램도 메모리 예산에 집계되어 넘치면 버려지고 돌려주면 반환되는지,
+ * 큐가 비어 있으면 타임아웃까지 기다리다가 도착하면 깨어나는지 확인합니다.
+ */
+TEST_F(UdsServerTest, DgramEndpointTest) {
+    UDS_SERVER_CONFIG config;
+    initUdsServerConfig(&config, (char*)TEST_SOCKET_PATH, TEST_CLIENT_COUNT);
+    config.pchDgramPath = TEST_DGRAM_PATH;
+    config.ullMemoryBudget = 5 * UDS_DGRAM_BUFFER_SIZE;    // 데이터그램 버퍼 5개
+    stopUds();
+    ASSERT_EQ(startUdsServerWithConfig(&g_stUdsServer, &config), 0);
+    ASSERT_GE(g_stUdsServer.iDgramSock, 0);
+
+    int sock = createUdsDgramClientSocket(TEST_DGRAM_PATH);
+    ASSERT_GE(sock, 0);
+    for (int i = 0; i < 10; ++i) {
+        std::string msg = "Telemetry_" + std::to_string(i);
+        ASSERT_EQ(udsSendMsg(sock, msg.c_str(), msg.size()), (int)msg.size());
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(DATA_WAIT_MS));
+    UDS_SERVER_STATS stats;
+    getUdsServerStats(&g_stUdsServer, &stats);
+    EXPECT_EQ(stats.ullQueuedBytes, 5 * UDS_DGRAM_BUFFER_SIZE);
+    EXPECT_EQ(stats.ullDroppedNewest, 5u);
+    for (int i = 0; i < 5; ++i) {
+        UDS_DGRAM_MSG* msg = nullptr;
+        ASSERT_EQ(udsServerRecvDgram(&g_stUdsServer, &msg, 0), 11);
+        EXPECT_EQ(msg->iPid, getpid());
+        EXPECT_EQ(std::string(msg->chData, msg->iLength), "Telemetry_" + std::to_string(i));
+        releaseUdsDgramMsg(&g_stUdsServer, msg);
+    }
+    getUdsServerStats(&g_stUdsServer, &stats);
+    EXPECT_EQ(stats.ullQueuedBytes, 0u);
+
+    UDS_DGRAM_MSG* msg = nullptr;
+    EXPECT_EQ(udsServerRecvDgram(&g_stUdsServer, &msg, 50), UDS_TIME_OUT);
+    EXPECT_EQ(msg, nullptr);
+
+    std::thread late([sock]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        udsSendMsg(sock, "late", 4);
+    });
+    ASSERT_EQ(udsServerRecvDgram(&g_stUdsServer, &msg, 1000), 4);
+    late.join();
+    EXPECT_EQ(std::string(msg->chData, msg->iLength), "late");
+    releaseUdsDgramMsg(&g_stUdsServer, msg);
+    close(sock);
+}
+
+/**
+ * @test ThreadConfigTest
+ * @brief 스레드 설정 테스트
+ *
+ * 수신/송신 스레드를 여러 개로 나누고 CPU 고정과 이름을 지정한 설정으로 서버를 시작하여,
+ * 모든 클라이언트의 루프백이 정상 동작하고 스레드 이름이 적용되는지 확인합니다.
+ * 종료 시 stopUdsServer()가 소유 스레드를 join합니다.
+ */
+TEST_F(UdsServerTest, ThreadConfigTest) {
+    UDS_SERVER_CONFIG config;
+    initUdsServerConfig(&config, (char*)TEST_SOCKET_PATH, TEST_CLIENT_COUNT);
+    config.iRecvThreadCount = 2;
+    config.iSendThreadCount = 3;
+    ASSERT_EQ(addUdsThreadCpu(&config.stRecvAttr, 0), 0);
+    ASSERT_EQ(addUdsThreadCpu(&config.stSendAttr, 0), 0);
+    snprintf(config.stRecvAttr.chName, sizeof(config.stRecvAttr.chName), "test-recv");
+    stopUds();
+    ASSERT_EQ(startUdsServerWithConfig(&g_stUdsServer, &config), 0);
+    ASSERT_EQ(g_stUdsServer.iThreadCount, 1 + 2 + 3);
+
+    char name[UDS_THREAD_NAME_LEN] = {0};
+    ASSERT_EQ(pthread_getname_np(g_stUdsServer.pstThreads[2].stThread, name, sizeof(name)), 0);
+    EXPECT_STREQ(name, "test-recv-1");
+
+    createClientsWithLoopback(TEST_CLIENT_COUNT);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    for (int i = 0; i < TEST_CLIENT_COUNT; ++i) {
+        if (g_stUdsServer.pstClients[i].iActive) {
+            std::string msg = "Sharded_" + std::to_string(i);
+            testData.push_back(msg);
+            char* data = strdup(msg.c_str());
+            queuePush(&g_stUdsServer.pstClients[i].stSendQueue, data, msg.size());
+        }
+    }
+    collectReceivedData();
+    int matched = 0;
+    for (const auto& expected : testData)
+        for (const auto& actual : receivedData)
+            if (expected == actual)
+                matched++;
+    ASSERT_EQ(matched, TEST_CLIENT_COUNT);
+}
+
+/**
+ * @test BusyPollRecvTest
+ * @brief 바쁜 대기(spin-then-block) 모드 수신 테스트
+ *
+ * iBusyPollUsec를 설정한 서버에서 udsServerRecv()가 바쁜 대기 구간과
+ * 블로킹 구간 모두에서 데이터를 받고, 데이터가 없으면 타임아웃을 반환하는지 확인합니다.
+ * 다른 슬롯에서 기다리는 소비자는 그 슬롯의 연결이 끊기면 타임아웃 전에 깨어나야 합니다.
+ */
+TEST_F(UdsServerTest, BusyPollRecvTest) {
+    UDS_SERVER_CONFIG config;
+    initUdsServerConfig(&config, (char*)TEST_SOCKET_PATH, TEST_CLIENT_COUNT);
+    config.iBusyPollUsec = 20 * 1000;
+    stopUds();
+    ASSERT_EQ(startUdsServerWithConfig(&g_stUdsServer, &config), 0);
+
+    int sock = createTestClientSocket();
+    ASSERT_GT(sock, 0);
+    clientSockets.push_back(sock);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    void* data = nullptr;
+    EXPECT_EQ(udsServerRecv(&g_stUdsServer, 0, &data, 50), UDS_TIME_OUT);
+
+    // 바쁜 대기 구간 안에 도착하는 데이터
+    std::thread early([sock]() { send(sock, "spin", 4, 0); });
+    int size = udsServerRecv(&g_stUdsServer, 0, &data, 1000);
+    early.join();
+    ASSERT_EQ(size, 4);
+    EXPECT_EQ(std::string((char*)data, size), "spin");
+    free(data);
+
+    // 바쁜 대기 예산을 넘긴 뒤 블로킹 구간에 도착하는 데이터
+    std::thread late([sock]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        send(sock, "block", 5, 0);
+    });
+    size = udsServerRecv(&g_stUdsServer, 0, &data, 1000);
+    late.join();
+    ASSERT_EQ(size, 5);
+    EXPECT_EQ(std::string((char*)data, size), "block");
+    free(data);
+
+    // 1번 슬롯 소비자는 0번 슬롯 데이터와 무관하게 기다리다가 연결이 끊기면 바로 돌아온다
+    int other = createTestClientSocket();
+    ASSERT_GT(other, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    int waitResult = 0;
+    auto waitStart = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration waited;
+    std::thread waiter([&]() {
+        void* otherData = nullptr;
+        waitResult = udsServerRecv(&g_stUdsServer, 1, &otherData, 3000);
+        waited = std::chrono::steady_clock::now() - waitStart;
+    });
+    send(sock, "mine", 4, 0);
+    ASSERT_EQ(udsServerRecv(&g_stUdsServer, 0, &data, 1000), 4);
+    free(data);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    close(other);
+    waiter.join();
+    EXPECT_EQ(waitResult, -1);
+    EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(waited).count(), 1000);
+}
+
+/**
+ * @test StreamLargeMessageTest
+ * @brief 대용량 메시지 청크 스트리밍 테스트
+ *
+ * 스트림 모드 서버에 수 MB 메시지를 두 번에 나누어 보내고,
+ * 소비자가 마지막 바이트 도착 전에 앞부분을 읽기 시작할 수 있는지,
+ * 청크 체인으로 받은 전체 내용과 뒤이은 작은 메시지가 올바른지 확인합니다.
+ */
+TEST_F(UdsServerTest, StreamLargeMessageTest) {
+    UDS_SERVER_CONFIG config;
+    initUdsServerConfig(&config, (char*)TEST_SOCKET_PATH, TEST_CLIENT_COUNT);
+    config.iStreamMode = 1;
+    stopUds();
+    ASSERT_EQ(startUdsServerWithConfig(&g_stUdsServer, &config), 0);
+
+    int sock = createTestClientSocket();
+    ASSERT_GT(sock, 0);
+    clientSockets.push_back(sock);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    const size_t total = 5 * 1024 * 1024 + 123;
+    std::vector<char> payload(total);
+    for (size_t i = 0; i < total; ++i)
+        payload[i] = (char)(i * 31 + 7);
+
+    std::thread sender([&]() {
+        unsigned long long header = htobe64(total);
+        send(sock, &header, sizeof(header), 0);
+        size_t half = total / 2;
+        for (size_t off = 0; off < half; )
+            off += send(sock, payload.data() + off, half - off, 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        for (size_t off = half; off < total; )
+            off += send(sock, payload.data() + off, total - off, 0);
+        struct iovec small = { (void*)"tail", 4 };
+        udsSendStreamMsg(sock, &small, 1);
+    });
+
+    void* data = nullptr;
+    ASSERT_GT(udsServerRecv(&g_stUdsServer, 0, &data, 1000), 0);
+    UDS_STREAM_MSG* msg = (UDS_STREAM_MSG*)data;
+    EXPECT_EQ(msg->ullLength, total);
+
+    UDS_STREAM_CURSOR cursor = {};
+    struct iovec iov[16];
+    std::vector<char> received;
+    bool startedEarly = false;
+    int count;
+    while ((count = udsStreamMsgRead(msg, &cursor, iov, 16, 1000)) > 0) {
+        if (msg->iState == UDS_STREAM_RECEIVING)
+            startedEarly = true;
+        for (int i = 0; i < count; ++i) {
+            EXPECT_LE(iov[i].iov_len, (size_t)UDS_STREAM_CHUNK_SIZE);
+            received.insert(received.end(), (char*)iov[i].iov_base, (char*)iov[i].iov_base + iov[i].iov_len);
+        }
+    }
+    EXPECT_EQ(count, 0);
+    EXPECT_TRUE(startedEarly);
+    EXPECT_TRUE(received == payload);
+    udsStreamMsgRelease(msg);
+
+    ASSERT_GT(udsServerRecv(&g_stUdsServer, 0, &data, 1000), 0);
+    msg = (UDS_STREAM_MSG*)data;
+    UDS_STREAM_CURSOR tailCursor = {};
+    ASSERT_EQ(udsStreamMsgRead(msg, &tailCursor, iov, 16, 1000), 1);
+    EXPECT_EQ(std::string((char*)iov[0].iov_base, iov[0].iov_len), "tail");
+    udsStreamMsgRelease(msg);
+    sender.join();
+}
+
+/**
+ * @test MemoryBudgetPolicyTest
+ * @brief 메모리 예산 및 과부하 정책 테스트
+ *
+ * 작은 예산을 설정한 서버에 소비하지 않는 메시지를 계속 보내어,
+ * 새 메시지 버림/오래된 메시지 버림/최다 사용 클라이언트 종료/읽기 중단 정책이
+ * 예산을 지키고 통계 카운터에 반영되는지 확인합니다.
+ * 읽기를 멈춘 동안 끊긴 클라이언트도 바로 해제되어야 합니다.
+ */
+TEST_F(UdsServerTest, MemoryBudgetPolicyTest) {
+    const int policies[] = { UDS_OVERLOAD_DROP_NEWEST, UDS_OVERLOAD_DROP_OLDEST, UDS_OVERLOAD_DISCONNECT_WORST,
+                             UDS_OVERLOAD_PAUSE_READS };
+    for (int policy : policies) {
+        UDS_SERVER_CONFIG config;
+        initUdsServerConfig(&config, (char*)TEST_SOCKET_PATH, TEST_CLIENT_COUNT);
+        // 읽기 중단은 메시지 3개로 예산이 꽉 차야 멈춘다
+        config.ullMemoryBudget = policy == UDS_OVERLOAD_PAUSE_READS ? 57 : 60;
+        config.iOverloadPolicy = policy;
+        stopUds();
+        ASSERT_EQ(startUdsServerWithConfig(&g_stUdsServer, &config), 0);
+
+        int sock = createTestClientSocket();
+        ASSERT_GT(sock, 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        for (int i = 0; i < 8; ++i) {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "Budget_Message_%04d", i);   // 19 bytes
+            send(sock, buf, strlen(buf), MSG_NOSIGNAL);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        UDS_SERVER_STATS stats;
+        getUdsServerStats(&g_stUdsServer, &stats);
+        EXPECT_LE(stats.ullPeakQueuedBytes, 60u) << "policy " << policy;
+        if (policy == UDS_OVERLOAD_DROP_NEWEST) {
+            EXPECT_EQ(stats.ullDroppedNewest, 5u);
+            void* data = nullptr;
+            ASSERT_EQ(udsServerRecv(&g_stUdsServer, 0, &data, 0), 19);
+            EXPECT_EQ(std::string((char*)data, 19), "Budget_Message_0000");
+            free(data);
+            // 송신 측도 같은 예산을 공유한다
+            getUdsServerStats(&g_stUdsServer, &stats);
+            char* out = strdup("0123456789012345678901234567890123456789");
+            EXPECT_EQ(udsServerQueueSend(&g_stUdsServer, 0, out, strlen(out)), -1);
+            free(out);
+        } else if (policy == UDS_OVERLOAD_DROP_OLDEST) {
+            EXPECT_EQ(stats.ullDroppedOldest, 5u);
+            void* data = nullptr;
+            ASSERT_EQ(udsServerRecv(&g_stUdsServer, 0, &data, 0), 19);
+            EXPECT_EQ(std::string((char*)data, 19), "Budget_Message_0005");
+            free(data);
+        } else if (policy == UDS_OVERLOAD_DISCONNECT_WORST) {
+            EXPECT_EQ(stats.ullDisconnects, 1u);
+            EXPECT_EQ(g_stUdsServer.iClientCount, 0);
+        } else {
+            EXPECT_GE(stats.ullPausedReads, 1u);
+            EXPECT_EQ(stats.ullDroppedNewest, 0u);
+            EXPECT_EQ(g_stUdsServer.iClientCount, 1);
+            close(sock);
+            sock = -1;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            getUdsServerStats(&g_stUdsServer, &stats);
+            EXPECT_EQ(g_stUdsServer.iClientCount, 0);
+            EXPECT_EQ(stats.ullQueuedBytes, 0u);
+        }
+        if (sock >= 0)
+            close(sock);
+    }
+}
+
+/**
+ * @test PauseReadsNoLossTest
+ * @brief 읽기 중단 정책에서 예산을 꽉 채워도 데이터를 잃지 않는지 테스트
+ *
+ * 예산보다 많이 보내 읽기가 멈춘 뒤 수신 큐를 비우면, 버린 메시지 없이
+ * 보낸 바이트가 순서대로 모두 도착해야 합니다.
+ */
+TEST_F(UdsServerTest, PauseReadsNoLossTest) {
+    UDS_SERVER_CONFIG config;
+    initUdsServerConfig(&config, (char*)TEST_SOCKET_PATH, TEST_CLIENT_COUNT);
+    config.ullMemoryBudget = 2100;
+    config.iOverloadPolicy = UDS_OVERLOAD_PAUSE_READS;
+    stopUds();
+    ASSERT_EQ(startUdsServerWithConfig(&g_stUdsServer, &config), 0);
+
+    int sock = createTestClientSocket();
+    ASSERT_GT(sock, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::string sent;
+    // 수신 큐 용량(10개)보다 예산이 먼저 차도록 큰 단위로 보낸다
+    for (int i = 0; i < 10; ++i) {
+        char buf[501];
+        snprintf(buf, sizeof(buf), "%04d%0496d", i, i);
+        ASSERT_EQ(send(sock, buf, 500, MSG_NOSIGNAL), 500);
+        sent.append(buf, 500);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    UDS_SERVER_STATS stats;
+    getUdsServerStats(&g_stUdsServer, &stats);
+    EXPECT_GE(stats.ullPausedReads, 1u);
+    EXPECT_LE(stats.ullPeakQueuedBytes, 2100u);
+
+    std::string received;
+    while (received.size() < sent.size()) {
+        void* data = nullptr;
+        int size = udsServerRecv(&g_stUdsServer, 0, &data, 1000);
+        ASSERT_GT(size, 0) << "received " << received.size() << " of " << sent.size();
+        received.append((char*)data, size);
+        free(data);
+    }
+    EXPECT_EQ(received, sent);
+    getUdsServerStats(&g_stUdsServer, &stats);
+    EXPECT_EQ(stats.ullDroppedNewest, 0u);
+    EXPECT_EQ(stats.ullDroppedBytes, 0u);
+    close(sock);
+}
+
+/**
+ * @test ConnectionTimerTest
+ * @brief 유휴 타임아웃, 하트비트, 송신 정체 감지 테스트
+ *
+ * 주기적으로 송신하는 클라이언트는 유지되고 아무것도 보내지 않는 클라이언트는
+ * 유휴 타임아웃으로 끊기는지, 하트비트가 주기적으로 도착하는지,
+ * 데이터를 읽지 않는 클라이언트가 송신 정체로 끊기는지 확인합니다.
+ */
+TEST_F(UdsServerTest, ConnectionTimerTest) {
+    static const char heartbeat[] = "HB";
+    UDS_SERVER_CONFIG config;
+    initUdsServerConfig(&config, (char*)TEST_SOCKET_PATH, TEST_CLIENT_COUNT);
+    config.iIdleTimeoutMsec = 200;
+    config.iHeartbeatMsec = 50;
+    config.pvHeartbeatData = heartbeat;
+    config.iHeartbeatSize = 2;
+    stopUds();
+    ASSERT_EQ(startUdsServerWithConfig(&g_stUdsServer, &config), 0);
+
+    int idleSock = createTestClientSocket();
+    int busySock = createTestClientSocket();
+    ASSERT_GT(idleSock, 0);
+    ASSERT_GT(busySock, 0);
+    for (int i = 0; i < 10; ++i) {
+        send(busySock, "ping", 4, MSG_NOSIGNAL);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    // 유휴 클라이언트는 하트비트를 받다가 서버가 끊어 EOF를 받는다
+    char buf[256];
+    std::string received;
+    int n;
+    while ((n = udsRecvMsgTimeout(idleSock, buf, sizeof(buf), 300)) > 0)
+        received.append(buf, n);
+    EXPECT_EQ(n, 0);
+    EXPECT_GE(received.size(), 4u);
+    EXPECT_EQ(received.find_first_not_of("HB"), std::string::npos);
+
+    UDS_SERVER_STATS stats;
+    getUdsServerStats(&g_stUdsServer, &stats);
+    EXPECT_EQ(stats.ullIdleTimeouts, 1u);
+    EXPECT_GE(stats.ullHeartbeats, 4u);
+    EXPECT_EQ(g_stUdsServer.iClientCount, 1);
+    close(idleSock);
+    close(busySock);
+
+    // 읽지 않는 클라이언트에게 계속 보내면 send()가 막히고 정체 감지로 끊긴다
+    initUdsServerConfig(&config, (char*)TEST_SOCKET_PATH, TEST_CLIENT_COUNT);
+    config.iSendStallMsec = 100;
+    stopUds();
+    ASSERT_EQ(startUdsServerWithConfig(&g_stUdsServer, &config), 0);
+    int stallSock = createTestClientSocket();
+    ASSERT_GT(stallSock, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // 보낼 것이 없는 연결은 정체 감지 타이머를 등록하지 않고, 다 보내면 취소한다
+    EXPECT_FALSE(g_stUdsServer.pstClients[0].stStallTimer.iArmed);
+    char* first = strdup("first");
+    ASSERT_EQ(udsServerQueueSend(&g_stUdsServer, 0, first, 5), 0);
+    char firstBuf[16];
+    ASSERT_EQ(udsRecvMsgTimeout(stallSock, firstBuf, sizeof(firstBuf), 500), 5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(g_stUdsServer.pstClients[0].stStallTimer.iArmed);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline) {
+        getUdsServerStats(&g_stUdsServer, &stats);
+        if (stats.ullSendStalls > 0)
+            break;
+        char* out = (char*)calloc(1, UDS_MAX_DATA_SIZE);
+        if (udsServerQueueSend(&g_stUdsServer, 0, out, UDS_MAX_DATA_SIZE) != 0) {
+            free(out);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    EXPECT_EQ(stats.ullSendStalls, 1u);
+    close(stallSock);
+}
+
+/**
+ * @brief 타이머 만료 시각을 pvArg가 가리키는 위치에 기록하는 콜백
+ */
+static long long recordTimerExpiry(UDS_TIMER* timer) {
+    *(unsigned long long*)timer->pvArg = getUdsMonotonicUsec();
+    return 0;
+}
+
+/**
+ * @test TimerWheelLevelBoundaryTest
+ * @brief 상위 레벨 현재 슬롯에 있는 타이머의 만료 시각 테스트
+ *
+ * 0레벨이 한 바퀴를 막 마친 틱에 내려와야 하는 상위 레벨 타이머가
+ * 최대 대기 시간까지 밀리지 않고 제시간에 만료되는지 확인합니다.
+ */
+TEST_F(UdsServerTest, TimerWheelLevelBoundaryTest) {
+    UDS_TIMER_WHEEL wheel;
+    UDS_TIMER early, boundary;
+    unsigned long long earlyUsec = 0, boundaryUsec = 0;
+
+    initUdsTimerWheel(&wheel);
+    unsigned long long startUsec = wheel.ullStartUsec;
+    initUdsTimer(&early, recordTimerExpiry, &earlyUsec, 0);
+    initUdsTimer(&boundary, recordTimerExpiry, &boundaryUsec, 0);
+    // 127틱 타이머가 만료된 직후 현재 틱은 128이 되고, 130틱 타이머는 1레벨의 현재 슬롯에 남아 있다
+    armUdsTimer(&wheel, &early, 127);
+    armUdsTimer(&wheel, &boundary, 130);
+
+    std::atomic<bool> wheelRunning{true};
+    std::thread wheelThread([&]() {
+        while (wheelRunning) {
+            waitUdsTimerWheel(&wheel, UDS_TIMER_MAX_WAIT_MSEC);
+            advanceUdsTimerWheel(&wheel);
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    wheelRunning = false;
+    wakeUdsTimerWheel(&wheel);
+    wheelThread.join();
+    destroyUdsTimerWheel(&wheel);
+
+    ASSERT_NE(earlyUsec, 0u);
+    ASSERT_NE(boundaryUsec, 0u);
+    EXPECT_GE(boundaryUsec - startUsec, 130000u);
+    EXPECT_LT(boundaryUsec - startUsec, 180000u);
+}
+
+/**
+ * @test HotRestartHandoffTest
+ * @brief 리스닝 소켓과 클라이언트 핸드오프 테스트
+ *
+ * 새 서버 인스턴스가 제어 소켓을 열고 기존 서버가 핸드오프하면,
+ * 기존 연결이 끊기지 않고 같은 슬롯 번호로 옮겨지며 소비되지 않은 수신 데이터,
+ * 이후 송수신, 새 연결 수락이 모두 새 서버에서 처리되고, 이전 서버의 API는 거부되는지 확인합니다.
+ */
+#define TEST_HANDOFF_PATH   "/tmp/test_handoff_socket"   ///< 테스트용 핸드오프 제어 소켓 경로
+TEST_F(UdsServerTest, HotRestartHandoffTest) {
+    int sock = createTestClientSocket();
+    ASSERT_GT(sock, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    send(sock, "before", 6, MSG_NOSIGNAL);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // 제어 소켓이 없으면 핸드오프는 실패하고 기존 서버가 계속 동작한다
+    EXPECT_EQ(handoffUdsServer(&g_stUdsServer, TEST_HANDOFF_PATH), -1);
+
+    UDS_SERVER newServer;
+    UDS_SERVER_CONFIG config;
+    initUdsServerConfig(&config, (char*)TEST_SOCKET_PATH, TEST_CLIENT_COUNT);
+    int newResult = -100;
+    std::thread successor([&]() {
+        newResult = startUdsServerFromHandoff(&newServer, &config, TEST_HANDOFF_PATH, 3000);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    UDS_CLIENT_HANDLE handle = getUdsClientHandle(&g_stUdsServer, 0);
+    ASSERT_NE(handle, UDS_INVALID_CLIENT_HANDLE);
+    ASSERT_EQ(handoffUdsServer(&g_stUdsServer, TEST_HANDOFF_PATH), 0);
+    successor.join();
+    ASSERT_EQ(newResult, 0);
+    EXPECT_EQ(newServer.iClientCount, 1);
+
+    // 넘긴 뒤의 이전 서버는 해제된 자원에 접근하지 않고 호출을 거부한다
+    void* stale = nullptr;
+    EXPECT_EQ(udsServerRecv(&g_stUdsServer, 0, &stale, 0), UDS_HANDING_OFF);
+    EXPECT_EQ(udsServerSend(&g_stUdsServer, handle, "late", 4), UDS_HANDING_OFF);
+    EXPECT_EQ(udsServerQueueSend(&g_stUdsServer, 0, stale, 4), UDS_HANDING_OFF);
+
+    void* data = nullptr;
+    ASSERT_EQ(udsServerRecv(&newServer, 0, &data, 500), 6);
+    EXPECT_EQ(std::string((char*)data, 6), "before");
+    free(data);
+
+    send(sock, "after", 5, MSG_NOSIGNAL);
+    ASSERT_EQ(udsServerRecv(&newServer, 0, &data, 500), 5);
+    EXPECT_EQ(std::string((char*)data, 5), "after");
+    free(data);
+
+    char* out = strdup("reply");
+    ASSERT_EQ(udsServerQueueSend(&newServer, 0, out, 5), 0);
+    char buf[16];
+    ASSERT_EQ(udsRecvMsgTimeout(sock, buf, sizeof(buf), 500), 5);
+    EXPECT_EQ(std::string(buf, 5), "reply");
+
+    int sock2 = createTestClientSocket();
+    ASSERT_GT(sock2, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(newServer.iClientCount, 2);
+
+    close(sock);
+    close(sock2);
+    stopUdsServer(&newServer);
+    startUds();     // TearDown에서 정리할 서버
+}
+
+/**
+ * @test CaptureReplayTest
+ * @brief 수신 트래픽 캡처 로그 테스트
+ *
+ * 캡처 모드로 실행한 서버가 연결, 수신 데이터, 연결 해제를 순서대로
+ * 시각과 함께 기록하고, 재생용 리더가 같은 내용을 그대로 읽어 내는지 확인합니다.
+ * 데이터그램 엔드포인트로 받은 데이터는 송신자 PID와 함께 별도 레코드로 남아야 합니다.
+ */
+#define TEST_CAPTURE_PATH   "/tmp/test_capture.bin"     ///< 테스트용 캡처 파일 경로
+TEST_F(UdsServerTest, CaptureReplayTest) {
+    static const char* messages[] = { "first", "second", "third" };
+    UDS_SERVER_CONFIG config;
+    initUdsServerConfig(&config, (char*)TEST_SOCKET_PATH, TEST_CLIENT_COUNT);
+    config.pchCapturePath = TEST_CAPTURE_PATH;
+    config.pchDgramPath = TEST_DGRAM_PATH;
+    stopUds();
+    ASSERT_EQ(startUdsServerWithConfig(&g_stUdsServer, &config), 0);
+
+    int sock = createTestClientSocket();
+    ASSERT_GT(sock, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    for (const char* message : messages) {
+        send(sock, message, strlen(message), MSG_NOSIGNAL);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    close(sock);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    int dgramSock = createUdsDgramClientSocket(TEST_DGRAM_PATH);
+    ASSERT_GE(dgramSock, 0);
+    ASSERT_EQ(udsSendMsg(dgramSock, "telemetry", 9), 9);
+    close(dgramSock);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    stopUds();
+
+    UDS_CAPTURE_LOG log;
+    ASSERT_EQ(openUdsCaptureLog(&log, TEST_CAPTURE_PATH), 0);
+    std::vector<const UDS_CAPTURE_RECORD*> records;
+    size_t offset = 0;
+    const UDS_CAPTURE_RECORD* record;
+    while ((record = nextUdsCaptureRecord(&log, &offset)) != nullptr)
+        records.push_back(record);
+
+    ASSERT_EQ(records.size(), 6u);
+    EXPECT_EQ(records[0]->uiType, (unsigned int)UDS_CAPTURE_OPEN);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(records[i + 1]->uiType, (unsigned int)UDS_CAPTURE_DATA);
+        EXPECT_EQ(std::string(UDS_CAPTURE_PAYLOAD(records[i + 1]), records[i + 1]->uiLength), messages[i]);
+    }
+    EXPECT_EQ(records[4]->uiType, (unsigned int)UDS_CAPTURE_CLOSE);
+    EXPECT_EQ(records[5]->uiType, (unsigned int)UDS_CAPTURE_DGRAM);
+    EXPECT_EQ(records[5]->uiClientId, (unsigned int)getpid());
+    EXPECT_EQ(std::string(UDS_CAPTURE_PAYLOAD(records[5]), records[5]->uiLength), "telemetry");
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (i < 5) {
+            EXPECT_EQ(records[i]->uiClientId, 0u);
+        }
+        if (i > 0) {
+            EXPECT_GT(records[i]->ullTimeNsec, records[i - 1]->ullTimeNsec);
+        }
+    }
+    closeUdsCaptureLog(&log);
+    unlink(TEST_CAPTURE_PATH);
+    startUds();     // TearDown에서 정리할 서버
+}
+
+/**
+ * @test MultiProducerSendTest
+ * @brief 다중 생산자 송신 API와 세대 핸들 테스트
+ *
+ * 여러 스레드가 서버 뮤텍스 없이 같은 클라이언트로 동시에 보낸 메시지가
+ * 빠짐없이 스레드별 순서대로 도착하는지, 연결이 끊긴 뒤 같은 슬롯에 새 클라이언트가
+ * 연결되면 이전 핸들로 보낸 메시지는 거부되고 새 연결로 가지 않는지 확인합니다.
+ */
+TEST_F(UdsServerTest, MultiProducerSendTest) {
+    const int producerCount = 8;
+    const int messagesPerProducer = 500;
+    const int messageSize = 8;      // "P<id:1><seq:6>" 고정 길이
+
+    int sock = createTestClientSocket();
+    ASSERT_GT(sock, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    UDS_CLIENT_HANDLE handle = getUdsClientHandle(&g_stUdsServer, 0);
+    ASSERT_NE(handle, UDS_INVALID_CLIENT_HANDLE);
+    EXPECT_EQ(getUdsClientHandle(&g_stUdsServer, 1), UDS_INVALID_CLIENT_HANDLE);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < producerCount; ++p) {
+        producers.emplace_back([&, p]() {
+            char message[16];
+            for (int i = 0; i < messagesPerProducer; ++i) {
+                snprintf(message, sizeof(message), "P%d%06d", p, i);
+                while (udsServerSend(&g_stUdsServer, handle, message, messageSize) != 0)
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    // 메시지 경계가 보존되지 않으므로 고정 길이로 잘라 생산자별 순번을 확인한다
+    std::string stream;
+    char buf[4096];
+    const size_t expected = (size_t)producerCount * messagesPerProducer * messageSize;
+    while (stream.size() < expected) {
+        int n = udsRecvMsgTimeout(sock, buf, sizeof(buf), 900);
+        if (n <= 0)
+            break;
+        stream.append(buf, n);
+    }
+    for (auto& producer : producers)
+        producer.join();
+    ASSERT_EQ(stream.size(), expected);
+    std::vector<int> nextSeq(producerCount, 0);
+    for (size_t off = 0; off < stream.size(); off += messageSize) {
+        int p = stream[off + 1] - '0';
+        ASSERT_TRUE(p >= 0 && p < producerCount);
+        EXPECT_EQ(atoi(stream.substr(off + 2, 6).c_str()), nextSeq[p]);
+        nextSeq[p]++;
+    }
+
+    // 같은 슬롯에 새 연결이 들어오면 이전 핸들은 거부된다
+    close(sock);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(udsServerSend(&g_stUdsServer, handle, "stale", 5), UDS_STALE_CLIENT);
+    int sock2 = createTestClientSocket();
+    ASSERT_GT(sock2, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    UDS_CLIENT_HANDLE handle2 = getUdsClientHandle(&g_stUdsServer, 0);
+    ASSERT_NE(handle2, UDS_INVALID_CLIENT_HANDLE);
+    EXPECT_NE(handle2, handle);
+    EXPECT_EQ(udsServerSend(&g_stUdsServer, handle, "stale", 5), UDS_STALE_CLIENT);
+    ASSERT_EQ(udsServerSend(&g_stUdsServer, handle2, "fresh", 5), 0);
+    ASSERT_EQ(udsRecvMsgTimeout(sock2, buf, sizeof(buf), 500), 5);
+    EXPECT_EQ(std::string(buf, 5), "fresh");
+
+    UDS_SERVER_STATS stats;
+    getUdsServerStats(&g_stUdsServer, &stats);
+    EXPECT_EQ(stats.ullStaleSends, 2u);
+    EXPECT_EQ(stats.ullQueuedBytes, 0u);
+    EXPECT_EQ(g_stUdsServer.pstClients[0].ullSendMpscBytes, 0u);
+    close(sock2);
+}
 #endif
 
 /**
@@ -0,0 +1,126 @@
+#ifndef UDS_CAPTURE_H
+#define UDS_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include <stddef.h>
+
+#define UDS_CAPTURE_MAGIC       "UDSCAP1"           ///< 파일 헤더 식별자 (NULL 포함 8바이트)
+#define UDS_CAPTURE_VERSION     1
+#define UDS_CAPTURE_ALIGN       8                   ///< 레코드 정렬 단위
+#define UDS_CAPTURE_GROW_BYTES  (4 * 1024 * 1024)   ///< 파일을 늘리는 단위
+#define UDS_CAPTURE_MAX_BYTES   (1ULL << 30)        ///< 기본 최대 캡처 크기 (1GB)
+
+#define UDS_CAPTURE_DATA        1                   ///< 클라이언트가 보낸 데이터
+#define UDS_CAPTURE_OPEN        2                   ///< 클라이언트 연결
+#define UDS_CAPTURE_CLOSE       3                   ///< 클라이언트 연결 해제
+#define UDS_CAPTURE_DGRAM       4                   ///< 데이터그램 엔드포인트로 받은 데이터 (uiClientId는 송신자 PID)
+
+/**
+ * @brief 캡처 파일 헤더 (파일 맨 앞 64바이트)
+ */
+typedef struct {
+    char chMagic[8];                    ///< UDS_CAPTURE_MAGIC
+    unsigned int uiVersion;             ///< UDS_CAPTURE_VERSION
+    unsigned int uiHeaderSize;          ///< 헤더 크기 (첫 레코드 위치)
+    unsigned long long ullStartRealtimeNsec; ///< 캡처 시작 시각 (CLOCK_REALTIME, ns)
+    unsigned long long ullDataBytes;    ///< 정상 종료 시 기록된 레코드 영역 크기 (0이면 레코드 타입으로 끝을 판단)
+    char chReserved[32];
+} UDS_CAPTURE_FILE_HEADER;
+
+/**
+ * @brief 캡처 레코드 헤더
+ *
+ * 뒤에 uiLength 바이트의 데이터가 오고, 다음 레코드는 UDS_CAPTURE_ALIGN 단위로 정렬됩니다.
+ * uiType은 데이터를 다 쓴 뒤 마지막에 기록하므로 0이면 기록이 끝나지 않은 레코드입니다.
+ */
+typedef struct {
+    unsigned int uiType;                ///< UDS_CAPTURE_DATA / OPEN / CLOSE / DGRAM
+    unsigned int uiClientId;            ///< 클라이언트 슬롯 인덱스 (DGRAM은 송신자 PID)
+    unsigned int uiLength;              ///< 데이터 길이
+    unsigned int uiReserved;
+    unsigned long long ullTimeNsec;     ///< 캡처 시작 후 경과 시간 (CLOCK_MONOTONIC, ns)
+} UDS_CAPTURE_RECORD;
+
+#define UDS_CAPTURE_PAYLOAD(pstRecord)  ((const char *)((const UDS_CAPTURE_RECORD *)(pstRecord) + 1))
+
+/**
+ * @brief mmap 기반 추가 전용 캡처 로그 (기록용)
+ *
+ * 최대 크기만큼 주소 공간을 미리 매핑해 두고, 기록할 위치는 원자적 덧셈으로 예약하므로
+ * 여러 수신 스레드가 잠금 없이 동시에 기록합니다. 파일은 UDS_CAPTURE_GROW_BYTES 단위로
+ * 늘어나며 이때만 뮤텍스를 잡습니다. 최대 크기를 넘으면 이후 레코드는 버립니다.
+ */
+typedef struct {
+    int iFd;                            ///< 캡처 파일 디스크립터
+    char *pchBase;                      ///< 매핑 시작 주소 (NULL이면 캡처 꺼짐)
+    unsigned long long ullMaxBytes;     ///< 레코드 영역 최대 크기
+    unsigned long long ullOffset;       ///< 다음 레코드 예약 위치 (레코드 영역 기준)
+    unsigned long long ullFileBytes;    ///< 현재 파일에 확보된 레코드 영역 크기
+    unsigned long long ullStartNsec;    ///< 캡처 시작 단조 시각(ns)
+    unsigned long long ullRecords;      ///< 기록한 레코드 수
+    unsigned long long ullDropped;      ///< 공간 부족으로 버린 레코드 수
+    int iFull;                          ///< 더 이상 기록할 수 없으면 1
+    pthread_mutex_t mutex;              ///< 파일 확장 보호용 뮤텍스
+} UDS_CAPTURE;
+
+/**
+ * @brief 캡처 파일 생성 및 매핑
+ *
+ * 같은 경로의 기존 파일은 덮어씁니다. 핸드오프 시 이전/다음 프로세스는 서로 다른 경로를 써야 합니다.
+ *
+ * @param pstCapture 캡처 구조체
+ * @param pchPath 캡처 파일 경로
+ * @param ullMaxBytes 최대 크기 (0이면 UDS_CAPTURE_MAX_BYTES)
+ * @return 성공 시 0, 실패 시 -1
+ */
+int openUdsCapture(UDS_CAPTURE *pstCapture, const char *pchPath, unsigned long long ullMaxBytes);
+
+/**
+ * @brief 기록된 크기로 파일을 잘라 내고 매핑 해제
+ *
+ * 기록 중인 스레드가 없을 때 호출해야 합니다.
+ */
+void closeUdsCapture(UDS_CAPTURE *pstCapture);
+
+/**
+ * @brief 레코드 하나를 기록 (캡처가 꺼져 있으면 아무것도 하지 않음)
+ */
+void captureUdsRecord(UDS_CAPTURE *pstCapture, int iType, int iClientId, const void *pvData, int iLength);
+
+/**
+ * @brief 읽기 전용으로 매핑한 캡처 로그 (재생용)
+ */
+typedef struct {
+    int iFd;                            ///< 캡처 파일 디스크립터
+    const char *pchBase;                ///< 매핑 시작 주소
+    size_t iSize;                       ///< 매핑 크기
+    unsigned long long ullStartRealtimeNsec; ///< 캡처 시작 시각
+} UDS_CAPTURE_LOG;
+
+/**
+ * @brief 캡처 파일을 읽기 전용으로 매핑
+ *
+ * @return 성공 시 0, 파일이 없거나 형식이 다르면 -1
+ */
+int openUdsCaptureLog(UDS_CAPTURE_LOG *pstLog, const char *pchPath);
+
+/**
+ * @brief 다음 레코드를 반환하고 위치를 전진
+ *
+ * 0으로 초기화한 위치를 반복해서 전달합니다.
+ *
+ * @return 레코드 포인터, 더 이상 완성된 레코드가 없으면 NULL
+ */
+const UDS_CAPTURE_RECORD* nextUdsCaptureRecord(const UDS_CAPTURE_LOG *pstLog, size_t *piOffset);
+
+void closeUdsCaptureLog(UDS_CAPTURE_LOG *pstLog);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
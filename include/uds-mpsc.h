@@ -0,0 +1,64 @@
+#ifndef UDS_MPSC_H
+#define UDS_MPSC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#define UDS_CACHE_LINE_SIZE 64      ///< 생산자/소비자 필드를 떼어 놓을 캐시 라인 크기
+
+/**
+ * @brief 침입형(intrusive) MPSC 큐 노드
+ *
+ * 큐에 넣을 구조체의 맨 앞에 내장합니다.
+ */
+typedef struct UDS_MPSC_NODE_TAG {
+    struct UDS_MPSC_NODE_TAG *pstNext; ///< 다음 노드
+} UDS_MPSC_NODE;
+
+/**
+ * @brief 잠금 없는 다중 생산자 단일 소비자 큐 (Vyukov 방식)
+ *
+ * 생산자는 머리 포인터를 원자적 교환 한 번으로 넘겨받고 이전 노드에 연결하므로
+ * 재시도나 잠금 없이 항상 끝납니다. 소비자는 한 번에 하나만 있어야 하며,
+ * 생산자가 교환과 연결 사이에 있으면 그 노드부터는 잠시 비어 있는 것처럼 보입니다.
+ * 생산자 쪽 머리와 소비자 쪽 꼬리는 서로 다른 캐시 라인에 둡니다.
+ */
+typedef struct {
+    UDS_MPSC_NODE *pstHead;         ///< 마지막으로 넣은 노드 (생산자가 교환)
+    char chPad[UDS_CACHE_LINE_SIZE - sizeof(UDS_MPSC_NODE *)];
+    UDS_MPSC_NODE *pstTail;         ///< 다음에 꺼낼 노드 (소비자 전용)
+    UDS_MPSC_NODE stStub;           ///< 큐가 비었을 때 자리를 지키는 노드
+} UDS_MPSC_QUEUE;
+
+/**
+ * @brief 빈 큐로 초기화
+ *
+ * 스텁 노드가 내장되어 있으므로 초기화 후에는 큐 구조체를 옮기면 안 됩니다.
+ */
+void initUdsMpscQueue(UDS_MPSC_QUEUE *pstQueue);
+
+/**
+ * @brief 노드를 넣음 (여러 스레드가 동시에 호출 가능)
+ */
+void pushUdsMpscQueue(UDS_MPSC_QUEUE *pstQueue, UDS_MPSC_NODE *pstNode);
+
+/**
+ * @brief 가장 오래된 노드를 꺼냄 (소비자 하나만 호출)
+ *
+ * @return 노드 포인터, 비어 있거나 넣는 중인 노드만 남았으면 NULL
+ */
+UDS_MPSC_NODE* popUdsMpscQueue(UDS_MPSC_QUEUE *pstQueue);
+
+/**
+ * @brief 꺼낼 노드가 없는지 확인 (소비자 하나만 호출)
+ */
+int isUdsMpscQueueEmpty(UDS_MPSC_QUEUE *pstQueue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
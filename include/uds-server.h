@@ -6,11 +6,84 @@ extern "C" {
 #endif
 
 #include <pthread.h>
+#include <sys/types.h>
+#include <sys/un.h>
 #include "queue.h"
 #include "uds.h"
+#include "uds-stream.h"
+#include "uds-timer.h"
+#include "uds-capture.h"
+#include "uds-mpsc.h"
 
 #define UDS_MAX_DATA_SIZE   1024    ///< 전송 가능한 최대 데이터 크기
 #define QUEUE_SIZE          64      ///< 큐 버퍼 크기
+#define UDS_DGRAM_BATCH     64      ///< recvmmsg() 한 번에 수신하는 최대 데이터그램 수
+#define UDS_DGRAM_QUEUE_SIZE 1024   ///< 데이터그램 수신 큐 크기
+#define UDS_THREAD_NAME_LEN 16      ///< 스레드 이름 최대 길이 (NULL 포함, pthread_setname_np 제한)
+#define UDS_MAX_CPUS        1024    ///< CPU 고정 마스크가 표현할 수 있는 최대 CPU 수
+#define UDS_CPU_MASK_WORDS  (UDS_MAX_CPUS / (8 * sizeof(unsigned long)))
+
+#define UDS_OVERLOAD_DROP_NEWEST        0   ///< 예산 초과 시 새로 들어온 메시지를 버림
+#define UDS_OVERLOAD_DROP_OLDEST        1   ///< 예산 초과 시 가장 오래된 메시지부터 버림
+#define UDS_OVERLOAD_DISCONNECT_WORST   2   ///< 예산 초과 시 가장 많이 쌓인 클라이언트를 끊음
+#define UDS_OVERLOAD_PAUSE_READS        3   ///< 예산 초과 시 소켓 읽기를 멈춤 (송신 측은 거부)
+
+#define UDS_QUEUE_RECV      0       ///< 수신 큐 방향
+#define UDS_QUEUE_SEND      1       ///< 송신 큐 방향
+#define UDS_QUEUE_CHUNK     2       ///< 스트림 모드 청크 (청크 풀에서 별도 집계)
+
+#define UDS_STALE_CLIENT    -3      ///< 핸들이 가리키던 연결이 끊겼거나 슬롯이 다른 연결에 재사용됨
+#define UDS_HANDING_OFF     -4      ///< 서버가 핸드오프 중이거나 이미 후속 프로세스로 넘어감
+#define UDS_INVALID_CLIENT_HANDLE 0ULL ///< 연결되지 않은 슬롯의 핸들
+
+/**
+ * @brief 세대 번호가 붙은 클라이언트 핸들
+ *
+ * 상위 32비트는 연결 세대, 하위 32비트는 슬롯 인덱스입니다.
+ * 슬롯이 새 연결에 재사용되면 세대가 바뀌어 이전 핸들은 거부됩니다.
+ */
+typedef unsigned long long UDS_CLIENT_HANDLE;
+
+/**
+ * @brief udsServerSend()로 넣은 송신 메시지 (데이터가 바로 뒤에 붙음)
+ */
+typedef struct {
+    UDS_MPSC_NODE stNode;    ///< 송신 MPSC 큐 노드 (맨 앞)
+    unsigned int uiGeneration; ///< 넣을 때 확인한 연결 세대
+    int iLength;             ///< 데이터 길이
+    char chData[];           ///< 데이터
+} UDS_SEND_MSG;
+
+/**
+ * @brief 데이터그램 수신 메시지
+ *
+ * 데이터그램 엔드포인트로 수신된 메시지와 송신자 정보를 담습니다.
+ * 버퍼는 UDS_MAX_DATA_SIZE 크기로 풀에서 재사용되므로, udsServerRecvDgram()으로 꺼낸
+ * 소비자는 free() 대신 releaseUdsDgramMsg()로 돌려줍니다.
+ */
+typedef struct UDS_DGRAM_MSG_TAG {
+    struct UDS_DGRAM_MSG_TAG *pstNext; ///< 빈 버퍼 목록 연결 (내부용)
+    pid_t iPid;              ///< 송신 프로세스 PID (자격 증명이 없으면 0)
+    uid_t uiUid;             ///< 송신 프로세스 UID
+    gid_t uiGid;             ///< 송신 프로세스 GID
+    char chSenderPath[sizeof(((struct sockaddr_un *)0)->sun_path)]; ///< 송신 소켓 주소 (미바인드 시 빈 문자열)
+    int iLength;             ///< 데이터 길이
+    char chData[];           ///< 데이터
+} UDS_DGRAM_MSG;
+
+#define UDS_DGRAM_BUFFER_SIZE   (sizeof(UDS_DGRAM_MSG) + UDS_MAX_DATA_SIZE) ///< 데이터그램 버퍼 하나의 크기 (메모리 예산 집계 단위)
+
+/**
+ * @brief 데이터그램 수신 버퍼 풀
+ *
+ * 소비자가 돌려준 버퍼를 iMaxFree개까지 보관했다가 다음 수신에 재사용합니다.
+ */
+typedef struct {
+    pthread_mutex_t mutex;   ///< 빈 버퍼 목록 보호용 뮤텍스
+    UDS_DGRAM_MSG *pstFree;  ///< 빈 버퍼 목록
+    int iFreeCount;          ///< 빈 버퍼 수
+    int iMaxFree;            ///< 보관할 최대 빈 버퍼 수
+} UDS_DGRAM_POOL;
 
 /**
  * @brief 클라이언트 정보 구조체
@@ -23,31 +96,160 @@ typedef struct {
     int iActive;             ///< 클라이언트 활성화 여부
     QUEUE stSendQueue;       ///< 송신 큐
     QUEUE stRecvQueue;       ///< 수신 큐
+    pthread_cond_t stRecvCond; ///< 이 슬롯의 수신 큐에 데이터가 들어왔음을 알리는 조건 변수 (서버 mutex와 함께 사용)
+    int iRecvWaiters;        ///< 이 슬롯에서 udsServerRecv()로 대기 중인 소비자 수
+    unsigned long ulRecvSeq; ///< 이 슬롯의 수신 큐 push 순번 (바쁜 대기 소비자가 뮤텍스 없이 확인)
+    int iCoalesceMaxBytes;   ///< 송신 병합 임계 바이트 (0이면 병합 비활성)
+    int iCoalesceDelayUsec;  ///< 송신 병합 최대 지연 시간(us)
+    char *pchCoalesceBuf;    ///< 송신 병합 버퍼
+    int iCoalesceLen;        ///< 송신 병합 버퍼에 쌓인 바이트 수
+    unsigned long long ullCoalesceStartUsec; ///< 병합 버퍼에 첫 데이터가 들어온 시각(us)
+    UDS_STREAM_RX stStreamRx; ///< 스트림 모드 프레임 수신 상태
+    unsigned long long ullRecvQueuedBytes; ///< 수신 큐에 집계된 바이트 수
+    unsigned long long ullSendQueuedBytes; ///< 송신 큐에 집계된 바이트 수
+    UDS_TIMER stIdleTimer;   ///< 유휴 타임아웃 타이머
+    UDS_TIMER stHeartbeatTimer; ///< 하트비트 주기 타이머
+    UDS_TIMER stStallTimer;  ///< 송신 정체 감지 타이머 (송신 백로그가 있는 동안 ullSendStartUsec를 주기적으로 확인)
+    unsigned long long ullLastRecvUsec; ///< 마지막으로 데이터를 수신한 단조 시각(us)
+    unsigned long long ullSendStartUsec; ///< 진행 중인 send()를 시작한 단조 시각(us), 보내는 중이 아니면 0
+    int iHeartbeatDue;       ///< 하트비트를 보낼 차례면 1 (송신 스레드가 전송 후 0으로 되돌림)
+    int iStallArmed;         ///< 송신 정체 감지 타이머를 등록해 두었으면 1 (서버 뮤텍스 아래에서 송신 스레드가 갱신)
+    unsigned int uiGeneration; ///< 연결될 때마다 증가하는 세대 번호 (0은 쓰지 않음)
+    UDS_MPSC_QUEUE stSendMpsc; ///< udsServerSend()용 잠금 없는 송신 큐 (UDS_SEND_MSG*, 소비는 서버 뮤텍스 아래에서)
+    unsigned long long ullSendMpscBytes; ///< stSendMpsc에 쌓인 바이트 수 (원자적으로 갱신, 연결 해제 후에도 유지)
+    unsigned long long ullChunkBytes; ///< 이 슬롯에서 수신한 스트림 메시지가 잡고 있는 청크 바이트 수 (원자적으로 갱신)
+    int iEvicted;            ///< 과부하 정책으로 끊겨 슬롯 해제를 기다리는 중이면 1
+    unsigned long ulSendSeq; ///< 이 슬롯에 송신할 일이 생길 때마다 증가 (담당 송신 스레드가 뮤텍스 없이 확인)
 } CLIENT;
 
+/**
+ * @brief 서버 메모리 사용량, 과부하 처리 및 연결 통계
+ */
+typedef struct {
+    unsigned long long ullQueuedBytes;    ///< 현재 큐와 청크에 잡혀 있는 바이트 수
+    unsigned long long ullPeakQueuedBytes; ///< 최대 집계 바이트 수 (예산이 0이면 udsServerSend()로 쌓인 바이트는 빠짐)
+    unsigned long long ullDroppedNewest;  ///< 예산 초과로 버린 새 메시지 수
+    unsigned long long ullDroppedOldest;  ///< 예산 초과로 버린 오래된 메시지 수
+    unsigned long long ullDroppedBytes;   ///< 버린 메시지의 총 바이트 수
+    unsigned long long ullDisconnects;    ///< 예산 초과로 끊은 클라이언트 수
+    unsigned long long ullPausedReads;    ///< 예산 초과로 수신 스레드가 소켓 읽기를 멈춘 횟수
+    unsigned long long ullIdleTimeouts;   ///< 유휴 타임아웃으로 끊은 클라이언트 수
+    unsigned long long ullSendStalls;     ///< 송신 정체로 끊은 클라이언트 수
+    unsigned long long ullHeartbeats;     ///< 전송한 하트비트 수
+    unsigned long long ullAccepts;        ///< 슬롯을 배정한 연결 수
+    unsigned long long ullReleases;       ///< 해제한 연결 수
+    unsigned long long ullRejects;        ///< 빈 슬롯이 없어 바로 닫은 연결 수
+    unsigned long long ullStaleSends;     ///< 끊긴/재사용된 연결의 핸들로 보내 거부하거나 버린 메시지 수
+} UDS_SERVER_STATS;
+
+/**
+ * @brief 서버 스레드 역할별 속성
+ *
+ * 같은 역할의 스레드(예: 수신 스레드 전체)에 공통으로 적용됩니다.
+ * 설정 실패(권한 부족 등)는 경고만 출력하고 스레드는 기본 속성으로 계속 동작합니다.
+ */
+typedef struct {
+    unsigned long aulCpuMask[UDS_CPU_MASK_WORDS]; ///< CPU 고정 마스크 (모두 0이면 고정하지 않음)
+    int iSchedPolicy;        ///< 스케줄링 정책 (SCHED_OTHER, SCHED_FIFO, SCHED_RR)
+    int iSchedPriority;      ///< SCHED_FIFO/SCHED_RR 우선순위
+    int iNice;               ///< nice 값 (SCHED_OTHER에서만 의미 있음)
+    char chName[UDS_THREAD_NAME_LEN]; ///< 스레드 이름 접두어 (뒤에 "-<번호>"가 붙음)
+} UDS_THREAD_ATTR;
+
+/**
+ * @brief UDS 서버 설정 구조체
+ *
+ * initUdsServerConfig()로 기본값을 채운 뒤 필요한 항목만 수정하여
+ * startUdsServerWithConfig()에 전달합니다.
+ */
+typedef struct {
+    char *pchUdsPath;        ///< 스트림 소켓 파일 경로
+    int iMaxClients;         ///< 최대 클라이언트 수
+    const char *pchDgramPath; ///< 데이터그램 소켓 파일 경로 (NULL이면 사용 안 함)
+    int iRecvThreadCount;    ///< 수신 스레드 수 (클라이언트 슬롯을 나누어 담당)
+    int iSendThreadCount;    ///< 송신 스레드 수 (클라이언트 슬롯을 나누어 담당)
+    int iBusyPollUsec;       ///< 유휴 시 블로킹 전 바쁜 대기(spin) 시간(us), 0이면 바로 블로킹
+    int iStreamMode;         ///< 1이면 길이 헤더 프레임을 청크 체인(UDS_STREAM_MSG*)으로 수신
+    unsigned long long ullStreamMaxSize; ///< 스트림 모드 최대 메시지 크기, 초과 시 연결 종료
+    int iStreamPoolChunks;   ///< 청크 풀에 보관할 최대 청크 수
+    unsigned long long ullMemoryBudget; ///< 모든 클라이언트 큐에 쌓일 수 있는 총 바이트 수 (0이면 무제한)
+    int iOverloadPolicy;     ///< 예산 초과 시 처리 정책 (UDS_OVERLOAD_*)
+    int iIdleTimeoutMsec;    ///< 이 시간(ms) 동안 수신이 없으면 연결 종료 (0이면 사용 안 함)
+    int iHeartbeatMsec;      ///< 하트비트 전송 주기(ms) (0이면 사용 안 함)
+    const void *pvHeartbeatData; ///< 하트비트로 보낼 데이터 (서버 종료 시까지 유효해야 함)
+    int iHeartbeatSize;      ///< 하트비트 데이터 크기
+    int iSendStallMsec;      ///< send() 한 번이 이 시간(ms) 넘게 막히면 연결 종료 (0이면 사용 안 함)
+    const char *pchCapturePath; ///< 수신 트래픽 캡처 파일 경로 (NULL이면 캡처하지 않음)
+    unsigned long long ullCaptureMaxBytes; ///< 캡처 파일 최대 크기 (0이면 UDS_CAPTURE_MAX_BYTES)
+    UDS_THREAD_ATTR stConnAttr;  ///< 연결 관리 스레드 속성
+    UDS_THREAD_ATTR stRecvAttr;  ///< 수신 스레드 속성
+    UDS_THREAD_ATTR stSendAttr;  ///< 송신 스레드 속성
+    UDS_THREAD_ATTR stDgramAttr; ///< 데이터그램 수신 스레드 속성
+    UDS_THREAD_ATTR stTimerAttr; ///< 타이머 스레드 속성
+} UDS_SERVER_CONFIG;
+
+struct UDS_SERVER_TAG;
+
+/**
+ * @brief 서버가 소유하는 스레드 정보
+ *
+ * 각 스레드 함수의 인자로 전달되며, 수신/송신 스레드는 
+ * iIndex 번째 몫(슬롯 인덱스 % iCount == iIndex)의 클라이언트만 처리합니다.
+ */
+typedef struct {
+    pthread_t stThread;      ///< 스레드 핸들
+    struct UDS_SERVER_TAG *pstServer; ///< 소속 서버
+    int iIndex;              ///< 같은 역할 내 스레드 번호
+    int iCount;              ///< 같은 역할의 스레드 수
+    const UDS_THREAD_ATTR *pstAttr; ///< 적용할 스레드 속성
+    void* (*pfnRoutine)(void*); ///< 스레드 함수
+    int iStarted;            ///< 생성 성공 여부 (join 대상)
+    int aiWakeFd[2];         ///< poll()을 깨우기 위한 논블로킹 파이프 (수신/송신/연결 관리 스레드만 사용)
+    int iSleeping;           ///< 송신 스레드가 wake 파이프에서 잠들어 있으면 1
+} UDS_SERVER_THREAD;
+
 /**
  * @brief UDS 서버 정보 구조체
  *
  * 서버 소켓과 연결된 클라이언트 목록 및 동기화를 위한 뮤텍스를 포함합니다.
  */
-typedef struct {
+typedef struct UDS_SERVER_TAG {
     int iServerSock;         ///< 서버 소켓 디스크립터
     int iRunning;            ///< 서버 실행 상태 플래그
     int iMaxClients;         ///< 최대 클라이언트 수
     int iClientCount;        ///< 현재 연결된 클라이언트 수
     CLIENT *pstClients;      ///< 클라이언트 목록 포인터
     pthread_mutex_t mutex;   ///< 전체 서버 상태 보호용 뮤텍스
+    int iDgramSock;          ///< 데이터그램 수신 소켓 디스크립터 (미사용 시 -1)
+    QUEUE stDgramQueue;      ///< 데이터그램 수신 큐 (UDS_DGRAM_MSG*)
+    UDS_DGRAM_POOL stDgramPool; ///< 데이터그램 수신 버퍼 풀
+    pthread_cond_t stDgramCond; ///< 데이터그램 수신 큐에 데이터가 들어왔음을 알리는 조건 변수 (mutex와 함께 사용)
+    int iDgramWaiters;       ///< udsServerRecvDgram()에서 대기 중인 소비자 수
+    unsigned long ulDgramSeq; ///< 데이터그램 수신 큐 push 순번 (바쁜 대기 소비자가 뮤텍스 없이 확인)
+    UDS_SERVER_CONFIG stConfig; ///< 시작 시 전달된 설정 사본
+    UDS_SERVER_THREAD *pstThreads; ///< 서버가 소유한 스레드 목록
+    int iThreadCount;        ///< 서버가 소유한 스레드 수
+    UDS_SERVER_THREAD *pstRecvThreads; ///< pstThreads 중 수신 스레드 시작 위치
+    UDS_SERVER_THREAD *pstSendThreads; ///< pstThreads 중 송신 스레드 시작 위치
+    UDS_CHUNK_POOL stChunkPool; ///< 스트림 모드 수신 청크 풀
+    UDS_SERVER_STATS stStats; ///< 메모리 사용량 및 과부하 처리 통계 (ullQueuedBytes는 청크 제외)
+    UDS_TIMER_WHEEL stTimerWheel; ///< 연결별 타이머 휠
+    UDS_CAPTURE stCapture;   ///< 수신 트래픽 캡처 로그 (pchCapturePath가 없으면 꺼짐)
+    int iHandingOff;         ///< 핸드오프 중이거나 넘긴 뒤면 1 (공개 API가 UDS_HANDING_OFF로 거부)
+    int iApiCallers;         ///< 공개 API 안에 들어와 있는 애플리케이션 스레드 수
+    int iReadPaused;         ///< 예산 부족으로 읽기를 멈춘 수신 스레드가 있으면 1 (예산이 풀리면 깨움)
 } UDS_SERVER;
 
 /**
  * @brief 클라이언트 연결 관리 스레드 함수
  *
+ * 서버가 직접 생성하고 stopUdsServer()에서 join하므로 사용자가 호출하지 않습니다.
  * 서버 소켓에서 새로운 클라이언트 연결 요청을 수락하고,
  * 빈 슬롯이 있는 경우 클라이언트 배열에 등록합니다.
  * 연결된 소켓은 CLIENT 구조체에 저장되며, 
  * 해당 클라이언트의 활성 플래그를 설정합니다.
  *
- * @param arg UDS_SERVER 구조체 포인터
+ * @param arg UDS_SERVER_THREAD 구조체 포인터
  * @return NULL
  */
 void* connectionManagerThread(void* arg);
@@ -57,9 +259,10 @@ void* connectionManagerThread(void* arg);
  *
  * poll()을 통해 다중 클라이언트의 소켓에서 수신 가능 여부를 감지하고,
  * 수신된 데이터를 클라이언트의 수신 큐에 저장합니다.
+ * 스트림 모드에서는 길이 헤더 단위로 UDS_STREAM_MSG를 만들어 청크 체인으로 수신합니다.
  * 클라이언트가 비정상적으로 종료된 경우 활성 상태를 false로 설정합니다.
  *
- * @param arg UDS_SERVER 구조체 포인터
+ * @param arg UDS_SERVER_THREAD 구조체 포인터
  * @return NULL
  */
 void* recvThread(void* arg);
@@ -71,15 +274,489 @@ void* recvThread(void* arg);
  * 큐에 데이터가 존재하면 해당 데이터를 클라이언트 소켓을 통해 전송합니다.
  * 전송 실패 시 클라이언트를 비활성화 처리합니다.
  *
- * @param arg UDS_SERVER 구조체 포인터
+ * @param arg UDS_SERVER_THREAD 구조체 포인터
  * @return NULL
  */
 void* sendThread(void* arg);
 
+/**
+ * @brief 데이터그램 수신 스레드 함수
+ *
+ * 데이터그램 소켓에서 recvmmsg()로 최대 UDS_DGRAM_BATCH개씩 묶어 수신하고,
+ * 송신자 자격 증명과 주소를 붙인 UDS_DGRAM_MSG로 stDgramQueue에 저장합니다.
+ * recvmmsg()가 stDgramPool에서 가져온 버퍼에 바로 받고, 큐에 넣을 때 버퍼 크기(UDS_DGRAM_BUFFER_SIZE)만큼
+ * 메모리 예산에 집계하며,
+ * 예산을 넘으면 정책과 관계없이 새 데이터그램을 버립니다.
+ * UDS_MAX_DATA_SIZE를 넘어 잘린 데이터그램은 버립니다.
+ *
+ * @param arg UDS_SERVER_THREAD 구조체 포인터
+ * @return NULL
+ */
+void* dgramRecvThread(void* arg);
+
+/**
+ * @brief 타이머 스레드 함수
+ *
+ * 유휴 타임아웃, 하트비트, 송신 정체 감지 중 하나라도 설정된 경우에만 생성됩니다.
+ * 다음 만료 예정 시각까지 잠들었다가 타이머 휠을 진행합니다.
+ * 만료된 연결은 소켓만 shutdown()하고, 슬롯 해제는 담당 수신 스레드가 합니다.
+ * 송신 스레드가 막힌 send()에서 서버 뮤텍스를 잡고 있어도 동작하도록 수신 스레드와 분리되어 있습니다.
+ *
+ * @param arg UDS_SERVER_THREAD 구조체 포인터
+ * @return NULL
+ */
+void* timerThread(void* arg);
+
+
+/**
+ * @brief 서버 설정 구조체를 기본값으로 초기화
+ *
+ * 수신/송신 스레드 각 1개, CPU 고정 없음, SCHED_OTHER, 데이터그램 엔드포인트 없음.
+ *
+ * @param pstConfig 초기화할 설정 구조체
+ * @param pchUdsPath 스트림 소켓 파일 경로
+ * @param iMaxClients 최대 클라이언트 수
+ */
+void initUdsServerConfig(UDS_SERVER_CONFIG *pstConfig, char* pchUdsPath, int iMaxClients);
+
+/**
+ * @brief 스레드 속성의 CPU 고정 마스크에 CPU 추가
+ *
+ * @param pstAttr 스레드 속성
+ * @param iCpu CPU 번호
+ * @return 성공 시 0, 범위를 벗어나면 -1
+ */
+int addUdsThreadCpu(UDS_THREAD_ATTR *pstAttr, int iCpu);
+
+/**
+ * @brief 설정에 따라 UDS 서버를 시작
+ *
+ * 소켓과 클라이언트 슬롯을 초기화하고 연결 관리/수신/송신(및 데이터그램) 스레드를
+ * 생성합니다. 생성된 스레드는 서버가 소유하며 stopUdsServer()에서 join됩니다.
+ *
+ * @param pstUdsServer UDS_SERVER 구조체 포인터
+ * @param pstConfig 서버 설정
+ * @return 성공 시 0, 실패 시 -1
+ */
+int startUdsServerWithConfig(UDS_SERVER *pstUdsServer, const UDS_SERVER_CONFIG *pstConfig);
 
+/**
+ * @brief 기본 설정으로 UDS 서버를 시작
+ *
+ * @param pstUdsServer UDS_SERVER 구조체 포인터
+ * @param pchUdsPath 스트림 소켓 파일 경로
+ * @param iUdsClientCount 최대 클라이언트 수
+ */
 void startUdsServer(UDS_SERVER *pstUdsServer, char* pchUdsPath, int iUdsClientCount);
+
+/**
+ * @brief UDS 서버 종료
+ *
+ * 모든 서버 스레드를 깨워 join한 뒤, 클라이언트 소켓과 큐, 서버 소켓을 정리합니다.
+ *
+ * @param pstUdsServer UDS_SERVER 구조체 포인터
+ */
 void stopUdsServer(UDS_SERVER *pstUdsServer);
 
+/**
+ * @brief 핸드오프로 실행 중인 서버의 리스닝 소켓과 클라이언트를 후속 프로세스에 넘김
+ *
+ * 후속 프로세스가 startUdsServerFromHandoff()로 열어 둔 제어 소켓에 연결한 뒤,
+ * 서버 스레드를 멈추고 SCM_RIGHTS로 리스닝 소켓과 각 클라이언트 소켓을 슬롯 번호,
+ * 아직 보내지 못한 송신 데이터, 소비되지 않은 수신 데이터와 함께 전달합니다.
+ * 리스닝 소켓과 클라이언트 소켓은 shutdown()하지 않으므로 연결이 끊기지 않습니다.
+ *
+ * 시작하는 순간부터 udsServerRecv(), udsServerQueueSend(), udsServerSend(),
+ * setUdsClientCoalescing()은 UDS_HANDING_OFF를 반환하고, 이미 그 안에 있던 호출이
+ * 모두 빠져나온 뒤에 큐를 넘깁니다. 제어 소켓 상대가 같은 UID가 아니면 아무것도 넘기지 않습니다.
+ *
+ * 성공하면 서버 자원이 정리되므로 stopUdsServer()를 다시 호출하지 않으며,
+ * 이후의 공개 API 호출도 계속 UDS_HANDING_OFF로 거부됩니다.
+ * 실패하면 서버는 원래 상태로 다시 동작합니다.
+ * 스트림 모드에서 수신 큐에 남은 메시지는 전달되지 않으므로 미리 소비해야 합니다.
+ *
+ * @param pstUdsServer 실행 중인 UDS_SERVER 구조체 포인터
+ * @param pchControlPath 후속 프로세스의 제어 소켓 경로
+ * @return 성공 시 0, 실패 시 -1
+ */
+int handoffUdsServer(UDS_SERVER *pstUdsServer, const char *pchControlPath);
+
+/**
+ * @brief 이전 프로세스로부터 핸드오프를 받아 서버를 시작
+ *
+ * pchControlPath에 제어 소켓을 만들고 이전 프로세스의 handoffUdsServer()를 기다립니다.
+ * 연결한 프로세스가 같은 UID가 아니면 거부합니다.
+ * 받은 리스닝 소켓을 그대로 사용하고 클라이언트를 같은 슬롯 번호로 복원한 뒤
+ * 서버 스레드를 시작합니다. 데이터그램 소켓은 넘겨받지 않고 새로 만듭니다.
+ *
+ * @param pstUdsServer UDS_SERVER 구조체 포인터
+ * @param pstConfig 서버 설정 (pchUdsPath는 사용하지 않음)
+ * @param pchControlPath 제어 소켓 경로
+ * @param iTimeoutMsec 이전 프로세스의 연결을 기다릴 최대 시간(ms)
+ * @return 성공 시 0, 기다리는 동안 연결이 없으면 UDS_TIME_OUT
+ *         (이 경우 startUdsServerWithConfig()로 새로 시작할 수 있음), 실패 시 -1
+ */
+int startUdsServerFromHandoff(UDS_SERVER *pstUdsServer, const UDS_SERVER_CONFIG *pstConfig,
+                              const char *pchControlPath, int iTimeoutMsec);
+
+/**
+ * @brief 설정을 검증하고 서버 상태를 초기화 (내부용)
+ *
+ * iServerSock이 음수면 pchUdsPath에 리스닝 소켓을 새로 만듭니다. 스레드는 만들지 않습니다.
+ *
+ * @return 성공 시 0, 설정이 잘못되면 -1
+ */
+int prepareUdsServer(UDS_SERVER *pstUdsServer, const UDS_SERVER_CONFIG *pstConfig, int iServerSock);
+
+/**
+ * @brief 서버 스레드를 생성 (내부용)
+ *
+ * @return 성공 시 0, 실패 시 서버를 정리하고 -1
+ */
+int launchUdsServerThreads(UDS_SERVER *pstUdsServer);
+
+/**
+ * @brief 서버 스레드를 깨워 모두 join (내부용)
+ *
+ * 소켓은 건드리지 않으므로 반환 후 호출자는 서버 상태를 단독으로 다룰 수 있습니다.
+ */
+void haltUdsServerThreads(UDS_SERVER *pstUdsServer);
+
+/**
+ * @brief 스레드가 멈춘 서버의 클라이언트, 소켓, 큐를 정리 (내부용)
+ */
+void destroyUdsServer(UDS_SERVER *pstUdsServer);
+
+/**
+ * @brief 공개 API 진입 표시 (내부용)
+ *
+ * 핸드오프 중이면 진입하지 않고 UDS_HANDING_OFF를 반환합니다.
+ * 0을 반환한 경우에만 API를 마칠 때 leaveUdsServerApi()를 호출합니다.
+ */
+int enterUdsServerApi(UDS_SERVER *pstUdsServer);
+
+/**
+ * @brief 공개 API 진입 표시 해제 (내부용)
+ */
+void leaveUdsServerApi(UDS_SERVER *pstUdsServer);
+
+/**
+ * @brief 빈 슬롯에 클라이언트 소켓을 등록 (내부용)
+ *
+ * 송수신 큐를 만들고 타이머를 등록한 뒤 슬롯을 활성화합니다.
+ * 호출자는 pstUdsServer->mutex를 잡고 있어야 합니다.
+ */
+void activateUdsClient(UDS_SERVER *pstUdsServer, int iClientIndex, int iClientFd);
+
+/**
+ * @brief 클라이언트 슬롯 해제 (내부용)
+ *
+ * 소켓을 닫고 송수신 큐와 병합 버퍼를 정리한 뒤 슬롯을 비활성화합니다.
+ * 호출자는 pstUdsServer->mutex를 잡고 있어야 합니다.
+ *
+ * @param pstUdsServer UDS_SERVER 구조체 포인터
+ * @param iClientIndex 클라이언트 슬롯 인덱스
+ */
+void releaseUdsClient(UDS_SERVER *pstUdsServer, int iClientIndex);
+
+/**
+ * @brief 클라이언트 슬롯을 담당하는 수신 스레드를 깨움 (내부용)
+ *
+ * 새 클라이언트가 등록되었을 때 poll() 대상 목록을 즉시 다시 만들도록 합니다.
+ *
+ * @param pstUdsServer UDS_SERVER 구조체 포인터
+ * @param iClientIndex 클라이언트 슬롯 인덱스
+ */
+void wakeUdsRecvThread(UDS_SERVER *pstUdsServer, int iClientIndex);
+
+/**
+ * @brief 클라이언트를 담당하는 송신 스레드가 잠들어 있으면 깨움 (내부용, 뮤텍스 불필요)
+ *
+ * @param pstUdsServer UDS 서버 구조체 포인터
+ * @param iClientIndex 클라이언트 슬롯 인덱스
+ */
+void wakeUdsSendThread(UDS_SERVER *pstUdsServer, int iClientIndex);
+
+/**
+ * @brief 클라이언트 타이머 노드 초기화 (내부용)
+ */
+void initUdsClientTimers(UDS_SERVER *pstUdsServer, int iClientIndex);
+
+/**
+ * @brief 새 연결의 유휴 타임아웃/하트비트 타이머 등록 (내부용, 송신 정체 감지는 updateUdsStallTimer())
+ */
+void startUdsClientTimers(UDS_SERVER *pstUdsServer, int iClientIndex);
+
+/**
+ * @brief 클라이언트의 모든 타이머 취소 (내부용)
+ *
+ * 반환 후에는 만료 콜백이 이 클라이언트의 소켓에 접근하지 않으므로,
+ * 소켓을 닫기 전에 호출해야 합니다.
+ */
+void stopUdsClientTimers(UDS_SERVER *pstUdsServer, int iClientIndex);
+
+/**
+ * @brief 송신 백로그 유무에 맞춰 송신 정체 감지 타이머를 등록/취소 (내부용)
+ *
+ * 송신 스레드가 보낼 데이터를 발견하면 등록하고, 다 보내 비면 취소하므로
+ * 보낼 것이 없는 연결은 타이머 휠에 올라가지 않습니다.
+ * 호출자는 pstUdsServer->mutex를 잡고 있어야 합니다.
+ */
+void updateUdsStallTimer(UDS_SERVER *pstUdsServer, int iClientIndex, int iBacklog);
+
+/**
+ * @brief 메모리 예산 확보 (내부용)
+ *
+ * 큐에 iSize 바이트를 더 넣을 수 있는지 확인하고, 초과 시 과부하 정책에 따라
+ * 다른 메시지를 버리거나 클라이언트를 하나 끊어 공간을 만듭니다. 성공하면 해당 방향의
+ * 큐에 집계합니다 (UDS_QUEUE_CHUNK는 청크 풀 사용량에 집계).
+ * 호출자는 pstUdsServer->mutex를 잡고 있어야 합니다.
+ *
+ * @return 넣을 수 있으면 1, 버려야 하면 0
+ */
+int reserveUdsMemory(UDS_SERVER *pstUdsServer, int iClientIndex, int iDirection, int iSize);
+
+/**
+ * @brief 큐에서 꺼낸 바이트를 예산에서 차감 (내부용)
+ *
+ * 집계된 양보다 많이 차감하지 않으므로 queuePush()로 직접 넣은 데이터를 꺼내도 안전합니다.
+ * 호출자는 pstUdsServer->mutex를 잡고 있어야 합니다.
+ */
+void releaseUdsMemory(UDS_SERVER *pstUdsServer, int iClientIndex, int iDirection, int iSize);
+
+/**
+ * @brief 뮤텍스 없이 메모리 예산 확보 (내부용, udsServerSend() 전용)
+ *
+ * 다른 큐의 메시지를 버릴 수 없으므로 예산을 넘으면 과부하 정책과 관계없이 거부합니다.
+ * 서버 전체 집계와 클라이언트의 ullSendMpscBytes에 더하므로, 다른 경로에서 과부하 정책이
+ * 동작할 때는 이 바이트도 최다 사용 클라이언트 선정과 오래된 메시지 버림 대상에 들어갑니다.
+ * 예산이 0이면 클라이언트별로만 집계하고 getUdsServerStats()가 조회할 때 합산합니다.
+ *
+ * @return 넣을 수 있으면 1, 버려야 하면 0
+ */
+int reserveUdsSharedMemory(UDS_SERVER *pstUdsServer, int iClientIndex, int iSize);
+
+/**
+ * @brief reserveUdsSharedMemory()로 확보한 바이트 차감 (내부용, 뮤텍스 불필요)
+ */
+void releaseUdsSharedMemory(UDS_SERVER *pstUdsServer, int iClientIndex, int iSize);
+
+/**
+ * @brief 송신 MPSC 큐에 uiGeneration 세대로 보낼 메시지를 복사해 넣음 (내부용, 뮤텍스 불필요)
+ *
+ * udsServerSend()와 핸드오프 복원이 함께 쓰며, 예산은 reserveUdsSharedMemory()로 집계합니다.
+ *
+ * @return 성공 시 0, 예산 초과나 할당 실패 시 -1
+ */
+int pushUdsSendMsg(UDS_SERVER *pstUdsServer, int iClientIndex, unsigned int uiGeneration, const char *pchData, int iSize);
+
+/**
+ * @brief 송신 MPSC 큐에서 현재 연결로 보낼 메시지 하나를 꺼냄 (내부용)
+ *
+ * 이전 세대(끊긴 연결)로 보낸 메시지는 버리고 ullStaleSends에 집계합니다.
+ * 꺼낸 메시지의 예산 집계는 이미 차감되어 있으며 호출자가 free()로 해제합니다.
+ * 호출자는 pstUdsServer->mutex를 잡고 있어야 합니다.
+ *
+ * @return 메시지 포인터, 보낼 메시지가 없으면 NULL
+ */
+UDS_SEND_MSG* popUdsSendMsg(UDS_SERVER *pstUdsServer, int iClientIndex);
+
+/**
+ * @brief 송신 MPSC 큐의 메시지를 모두 버림 (내부용)
+ *
+ * 연결 해제나 서버 종료 시 호출하며, 호출자는 pstUdsServer->mutex를 잡고 있거나
+ * 송신 스레드가 멈춘 상태여야 합니다.
+ */
+void discardUdsSendMsgs(UDS_SERVER *pstUdsServer, int iClientIndex);
+
+/**
+ * @brief 데이터그램 수신 버퍼 풀 초기화/정리 (내부용)
+ */
+void initUdsDgramPool(UDS_DGRAM_POOL *pstPool, int iMaxFree);
+void destroyUdsDgramPool(UDS_DGRAM_POOL *pstPool);
+
+/**
+ * @brief 데이터그램 수신 큐에 남은 메시지를 모두 풀에 돌려줌 (내부용)
+ */
+void discardUdsDgramMsgs(UDS_SERVER *pstUdsServer);
+
+/**
+ * @brief 데이터그램 버퍼 iSize 바이트를 메모리 예산에 집계 (내부용, 뮤텍스 불필요)
+ *
+ * @return 성공 시 1, 예산 초과로 버려야 하면 0
+ */
+int reserveUdsDgramMemory(UDS_SERVER *pstUdsServer, int iSize);
+
+/**
+ * @brief reserveUdsDgramMemory()로 집계한 바이트를 반환 (내부용, 뮤텍스 불필요)
+ */
+void releaseUdsDgramMemory(UDS_SERVER *pstUdsServer, int iSize);
+
+/**
+ * @brief 메모리 예산 안에 ullNeedBytes를 더 넣을 수 없는지 확인 (내부용, 뮤텍스 불필요)
+ */
+int isUdsMemoryShort(UDS_SERVER *pstUdsServer, unsigned long long ullNeedBytes);
+
+/**
+ * @brief 소켓에서 읽기 전에 남은 예산에서 최대 iMaxSize 바이트를 수신 큐 몫으로 확보 (내부용)
+ *
+ * 확보한 만큼만 읽으면 읽은 뒤 예산이 모자라 데이터를 버리는 일이 없습니다.
+ * 쓰지 않은 바이트는 releaseUdsMemory()로 돌려줘야 합니다.
+ * 호출자는 pstUdsServer->mutex를 잡고 있어야 합니다.
+ *
+ * @return 확보한 바이트 수, 남은 예산이 없으면 0
+ */
+int reserveUdsReadRoom(UDS_SERVER *pstUdsServer, int iClientIndex, int iMaxSize);
+
+/**
+ * @brief 수신 스레드가 읽기를 멈추기 전에 깨워 달라고 표시 (내부용, 뮤텍스 불필요)
+ *
+ * 표시한 뒤에도 ullNeedBytes를 넣을 수 없을 때만 멈춰야 합니다.
+ *
+ * @return 멈춰야 하면 1, 그 사이 예산이 풀렸으면 0
+ */
+int pauseUdsReads(UDS_SERVER *pstUdsServer, unsigned long long ullNeedBytes);
+
+/**
+ * @brief 예산을 돌려준 뒤 읽기를 멈춘 수신 스레드를 깨움 (내부용, 뮤텍스 불필요)
+ */
+void resumeUdsReads(UDS_SERVER *pstUdsServer);
+
+/**
+ * @brief iClientIndex 슬롯의 수신 큐에 데이터가 들어왔음을 그 슬롯의 소비자에게 알림 (내부용)
+ *
+ * 호출자는 pstUdsServer->mutex를 잡고 있어야 합니다.
+ */
+void signalUdsRecv(UDS_SERVER *pstUdsServer, int iClientIndex);
+
+/**
+ * @brief iClientIndex 슬롯에 송신할 일이 생겼음을 송신 스레드에 알림 (내부용, 뮤텍스 불필요)
+ */
+void signalUdsSend(UDS_SERVER *pstUdsServer, int iClientIndex);
+
+/**
+ * @brief 단조 증가 시계의 현재 시각(us) (내부용)
+ */
+unsigned long long getUdsMonotonicUsec(void);
+
+/**
+ * @brief 바쁜 대기 루프 한 번의 CPU 양보 (내부용)
+ *
+ * x86에서는 pause 명령으로 하이퍼스레드 형제 코어에 자원을 양보합니다.
+ */
+void udsCpuRelax(void);
+
+/**
+ * @brief 클라이언트 수신 큐에서 데이터 하나를 꺼냄
+ *
+ * 큐가 비어 있으면 서버의 iBusyPollUsec 동안 바쁜 대기로 확인한 뒤,
+ * 남은 시간은 조건 변수로 블로킹하며 수신 스레드의 알림을 기다립니다.
+ * 꺼낸 데이터는 호출자가 free()로 해제합니다.
+ * 메모리 예산 집계를 위해 queuePop() 대신 이 함수로 꺼내야 합니다.
+ *
+ * @param pstUdsServer UDS_SERVER 구조체 포인터
+ * @param iClientIndex 클라이언트 슬롯 인덱스
+ * @param ppvData 꺼낸 데이터 포인터를 저장할 위치
+ * @param iTimeoutMsec 최대 대기 시간(ms), 0이면 대기하지 않음
+ * @return 성공 시 데이터 크기, 타임아웃 시 UDS_TIME_OUT, 핸드오프 중이면 UDS_HANDING_OFF, 비활성 슬롯이면 -1
+ */
+int udsServerRecv(UDS_SERVER *pstUdsServer, int iClientIndex, void **ppvData, int iTimeoutMsec);
+
+/**
+ * @brief 데이터그램 수신 큐에서 메시지 하나를 꺼냄
+ *
+ * udsServerRecv()와 같이 큐가 비어 있으면 서버의 iBusyPollUsec 동안 바쁜 대기로 확인한 뒤,
+ * 남은 시간은 조건 변수로 블로킹하며 데이터그램 수신 스레드의 알림을 기다립니다.
+ * 꺼낸 메시지는 다 쓴 뒤 releaseUdsDgramMsg()로 돌려줘야 예산과 버퍼가 반환됩니다.
+ * 메모리 예산 집계를 위해 queuePop() 대신 이 함수로 꺼내야 합니다.
+ *
+ * @param pstUdsServer UDS_SERVER 구조체 포인터
+ * @param ppstMsg 꺼낸 메시지 포인터를 저장할 위치
+ * @param iTimeoutMsec 최대 대기 시간(ms), 0이면 대기하지 않음
+ * @return 성공 시 데이터 크기(0 이상), 타임아웃 시 UDS_TIME_OUT, 핸드오프 중이면 UDS_HANDING_OFF,
+ *         데이터그램 엔드포인트가 없으면 -1
+ */
+int udsServerRecvDgram(UDS_SERVER *pstUdsServer, UDS_DGRAM_MSG **ppstMsg, int iTimeoutMsec);
+
+/**
+ * @brief udsServerRecvDgram()으로 꺼낸 메시지를 풀에 돌려주고 예산을 반환
+ *
+ * @param pstUdsServer UDS_SERVER 구조체 포인터
+ * @param pstMsg 돌려줄 메시지 (NULL이면 무시)
+ */
+void releaseUdsDgramMsg(UDS_SERVER *pstUdsServer, UDS_DGRAM_MSG *pstMsg);
+
+/**
+ * @brief 클라이언트 송신 큐에 데이터를 넣음
+ *
+ * 메모리 예산 집계와 과부하 정책을 적용한 뒤 송신 큐에 넣습니다.
+ * 성공하면 pvData(malloc으로 할당된 메모리)의 소유권이 서버로 넘어가며,
+ * 실패하면 호출자가 해제해야 합니다.
+ * queuePush()로 직접 넣은 데이터는 예산에 집계되지 않습니다.
+ *
+ * @param pstUdsServer UDS_SERVER 구조체 포인터
+ * @param iClientIndex 클라이언트 슬롯 인덱스
+ * @param pvData 전송할 데이터
+ * @param iSize 데이터 크기
+ * @return 성공 시 0, 핸드오프 중이면 UDS_HANDING_OFF, 비활성 슬롯·큐 포화·예산 초과 시 -1
+ */
+int udsServerQueueSend(UDS_SERVER *pstUdsServer, int iClientIndex, void *pvData, int iSize);
+
+/**
+ * @brief 슬롯에 현재 연결된 클라이언트의 핸들 조회
+ *
+ * 받은 요청에 응답할 때는 udsServerRecv() 전에 핸들을 먼저 얻어 두어야,
+ * 그 사이 슬롯이 재사용되더라도 응답이 새 연결로 가지 않고 거부됩니다.
+ *
+ * @param pstUdsServer UDS_SERVER 구조체 포인터
+ * @param iClientIndex 클라이언트 슬롯 인덱스
+ * @return 클라이언트 핸들, 연결되지 않은 슬롯이거나 핸드오프 중이면 UDS_INVALID_CLIENT_HANDLE
+ */
+UDS_CLIENT_HANDLE getUdsClientHandle(UDS_SERVER *pstUdsServer, int iClientIndex);
+
+/**
+ * @brief 여러 애플리케이션 스레드에서 동시에 호출할 수 있는 송신 API
+ *
+ * 데이터를 복사해 클라이언트별 잠금 없는 MPSC 큐에 넣으므로 서버 뮤텍스를 잡지 않고,
+ * 호출자는 반환 즉시 pchData를 재사용할 수 있습니다. 같은 스레드에서 같은 클라이언트로
+ * 보낸 메시지의 순서는 유지됩니다. 큐 길이 제한은 없으며 메모리 예산을 넘으면
+ * 과부하 정책과 관계없이 거부합니다. 쌓인 바이트는 클라이언트별로도 집계되므로 다른 경로에서
+ * 예산을 넘으면 DROP_OLDEST/DISCONNECT_WORST 정책이 이 메시지를 버리거나 느린 클라이언트를 끊습니다.
+ * 서버를 멈추기 전에 호출을 끝내야 합니다.
+ *
+ * @param pstUdsServer UDS_SERVER 구조체 포인터
+ * @param ullHandle getUdsClientHandle()로 얻은 클라이언트 핸들
+ * @param pchData 전송할 데이터
+ * @param iSize 데이터 크기
+ * @return 성공 시 0, 연결이 끊겼거나 슬롯이 재사용되었으면 UDS_STALE_CLIENT,
+ *         핸드오프 중이면 UDS_HANDING_OFF, 그 외 실패 시 -1
+ */
+int udsServerSend(UDS_SERVER *pstUdsServer, UDS_CLIENT_HANDLE ullHandle, const char *pchData, int iSize);
+
+/**
+ * @brief 서버 메모리 사용량, 과부하 처리 및 연결 통계 조회
+ *
+ * @param pstUdsServer UDS_SERVER 구조체 포인터
+ * @param pstStats 통계를 복사할 위치
+ */
+void getUdsServerStats(UDS_SERVER *pstUdsServer, UDS_SERVER_STATS *pstStats);
+
+/**
+ * @brief 클라이언트별 송신 병합(coalescing) 모드 설정
+ *
+ * 송신 큐의 작은 메시지들을 병합 버퍼에 모아 두었다가,
+ * 버퍼가 iMaxBytes 이상 차거나 첫 메시지가 들어온 뒤 iDelayUsec가 지나면
+ * 한 번의 send()로 전송합니다. 메시지 경계는 보존되지 않으므로
+ * 수신 측은 스트림으로 처리해야 합니다.
+ *
+ * @param pstUdsServer UDS_SERVER 구조체 포인터
+ * @param iClientIndex 클라이언트 슬롯 인덱스
+ * @param iMaxBytes 병합 임계 바이트 (0이면 병합 해제)
+ * @param iDelayUsec 최대 지연 시간(us)
+ * @return 성공 시 0, 핸드오프 중이면 UDS_HANDING_OFF, 실패 시 -1
+ */
+int setUdsClientCoalescing(UDS_SERVER *pstUdsServer, int iClientIndex, int iMaxBytes, int iDelayUsec);
+
 #ifdef __cplusplus
 }
 #endif
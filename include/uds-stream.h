@@ -0,0 +1,149 @@
+#ifndef UDS_STREAM_H
+#define UDS_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+#define UDS_STREAM_CHUNK_SIZE   (64 * 1024)         ///< 청크 하나의 데이터 크기
+#define UDS_STREAM_HEADER_SIZE  8                   ///< 프레임 길이 헤더 크기 (64비트 빅엔디언)
+#define UDS_STREAM_MAX_SIZE     (1ULL << 30)        ///< 기본 최대 메시지 크기 (1GB)
+#define UDS_STREAM_POOL_CHUNKS  256                 ///< 기본 풀 보관 청크 수 (16MB)
+
+#define UDS_STREAM_RECEIVING    0                   ///< 수신 중
+#define UDS_STREAM_COMPLETE     1                   ///< 마지막 바이트까지 수신 완료
+#define UDS_STREAM_ABORTED      2                   ///< 수신 도중 연결 종료
+
+#define UDS_STREAM_PAUSED       (-3)                ///< 메모리 예산 초과로 이번 수신을 건너뜀 (recvUdsStream 반환값)
+
+/**
+ * @brief 고정 크기 수신 청크
+ */
+typedef struct UDS_CHUNK_TAG {
+    struct UDS_CHUNK_TAG *pstNext;  ///< 다음 청크
+    size_t iLength;                 ///< 채워진 바이트 수
+    char chData[UDS_STREAM_CHUNK_SIZE]; ///< 데이터
+} UDS_CHUNK;
+
+/**
+ * @brief 청크 풀
+ *
+ * 해제된 청크를 최대 iMaxFree개까지 보관했다가 재사용합니다.
+ */
+typedef struct {
+    pthread_mutex_t mutex;          ///< 풀 보호용 뮤텍스
+    UDS_CHUNK *pstFree;             ///< 재사용 대기 청크 목록
+    int iFreeCount;                 ///< 보관 중인 청크 수
+    int iMaxFree;                   ///< 최대 보관 청크 수
+    unsigned long long ullInUseBytes; ///< 메시지에 연결되어 사용 중인 청크 바이트 수
+    void (*pfnRelease)(void *pvArg); ///< 메시지의 청크를 돌려준 뒤 호출할 함수 (없으면 NULL)
+    void *pvReleaseArg;             ///< pfnRelease 인자
+} UDS_CHUNK_POOL;
+
+/**
+ * @brief 청크 체인으로 수신되는 대용량 메시지
+ *
+ * 헤더를 받는 즉시 수신 큐에 들어가므로, 소비자는 마지막 바이트가
+ * 도착하기 전부터 udsStreamMsgRead()로 앞부분을 처리할 수 있습니다.
+ * 다 쓴 메시지는 free()가 아니라 udsStreamMsgRelease()로 해제합니다.
+ */
+typedef struct {
+    unsigned long long ullLength;   ///< 전체 메시지 길이
+    unsigned long long ullReceived; ///< 현재까지 수신된 길이
+    int iState;                     ///< UDS_STREAM_RECEIVING / COMPLETE / ABORTED
+    UDS_CHUNK *pstHead;             ///< 첫 청크
+    UDS_CHUNK *pstTail;             ///< 마지막 청크
+    int iRefCount;                  ///< 참조 수 (수신 스레드 + 소비자)
+    UDS_CHUNK_POOL *pstPool;        ///< 청크를 돌려줄 풀
+    unsigned long long *pullOwnerBytes; ///< 청크 바이트를 함께 집계할 클라이언트 카운터
+    pthread_mutex_t mutex;          ///< 메시지 상태 보호용 뮤텍스
+    pthread_cond_t cond;            ///< 데이터 도착 알림
+} UDS_STREAM_MSG;
+
+/**
+ * @brief 메시지 읽기 위치
+ *
+ * 0으로 초기화한 뒤 udsStreamMsgRead()에 반복해서 전달합니다.
+ */
+typedef struct {
+    UDS_CHUNK *pstChunk;            ///< 현재 청크
+    size_t iChunkOffset;            ///< 현재 청크 내 위치
+    unsigned long long ullOffset;   ///< 메시지 내 위치
+} UDS_STREAM_CURSOR;
+
+/**
+ * @brief 클라이언트별 프레임 수신 상태
+ */
+typedef struct {
+    unsigned char uchHeader[UDS_STREAM_HEADER_SIZE]; ///< 수신 중인 길이 헤더
+    int iHeaderLen;                 ///< 수신된 헤더 바이트 수
+    UDS_STREAM_MSG *pstMsg;         ///< 수신 중인 메시지 (없으면 NULL)
+    unsigned long long ullSkip;     ///< 큐가 가득 차 버리는 중인 남은 바이트 수
+} UDS_STREAM_RX;
+
+void initUdsChunkPool(UDS_CHUNK_POOL *pstPool, int iMaxFree);
+void destroyUdsChunkPool(UDS_CHUNK_POOL *pstPool);
+
+/**
+ * @brief 수신된 부분을 iovec으로 가져옴
+ *
+ * 커서 위치 이후 이미 도착한 데이터를 최대 iIovMax개의 iovec으로 채우고 커서를 전진시킵니다.
+ * 새 데이터가 없으면 iTimeoutMsec 동안 도착을 기다립니다.
+ * iovec이 가리키는 메모리는 메시지를 해제하기 전까지 유효합니다.
+ *
+ * @param pstMsg 메시지
+ * @param pstCursor 읽기 위치
+ * @param pstIov 결과 iovec 배열
+ * @param iIovMax iovec 배열 크기
+ * @param iTimeoutMsec 최대 대기 시간(ms)
+ * @return 채운 iovec 수, 메시지 끝이면 0, 타임아웃 시 UDS_TIME_OUT, 수신 중단 시 -1
+ */
+int udsStreamMsgRead(UDS_STREAM_MSG *pstMsg, UDS_STREAM_CURSOR *pstCursor, struct iovec *pstIov, int iIovMax, int iTimeoutMsec);
+
+/**
+ * @brief 메시지 참조 해제
+ *
+ * 마지막 참조가 해제되면 청크를 풀로 돌려줍니다.
+ * 서버를 종료하기 전에 꺼낸 메시지를 모두 해제해야 합니다.
+ */
+void udsStreamMsgRelease(UDS_STREAM_MSG *pstMsg);
+
+/**
+ * @brief 길이 헤더를 붙여 하나의 프레임으로 전송 (클라이언트용)
+ *
+ * 부분 전송을 처리하며 모든 바이트를 보낼 때까지 반복합니다.
+ *
+ * @param iSock 소켓 디스크립터
+ * @param pstIov 전송할 데이터 iovec 배열
+ * @param iIovCount iovec 수
+ * @return 성공 시 0, 실패 시 -1
+ */
+int udsSendStreamMsg(int iSock, const struct iovec *pstIov, int iIovCount);
+
+struct UDS_SERVER_TAG;
+
+/**
+ * @brief 프레임 수신 처리 (내부용)
+ *
+ * 읽기 가능한 소켓에서 헤더 또는 현재 메시지의 다음 청크를 한 번 수신합니다.
+ * 헤더가 완성되면 새 메시지를 클라이언트 수신 큐에 넣습니다.
+ *
+ * @return 수신한 바이트 수, 메모리 예산 초과 시 UDS_STREAM_PAUSED,
+ *         연결 종료 또는 프로토콜 오류 시 그 외의 0 이하 값
+ */
+int recvUdsStream(struct UDS_SERVER_TAG *pstUdsServer, int iClientIndex);
+
+/**
+ * @brief 수신 중인 메시지를 중단 처리 (내부용)
+ */
+void abortUdsStreamRx(UDS_STREAM_RX *pstRx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef UDS_TIMER_H
+#define UDS_TIMER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+
+#define UDS_TIMER_TICK_MSEC     1       ///< 타이머 휠 한 틱의 길이(ms)
+#define UDS_TIMER_WHEEL_BITS    6       ///< 레벨당 슬롯 수의 비트 수
+#define UDS_TIMER_WHEEL_SLOTS   (1 << UDS_TIMER_WHEEL_BITS) ///< 레벨당 슬롯 수
+#define UDS_TIMER_WHEEL_LEVELS  4       ///< 계층 수 (64^4 틱, 약 4.6시간까지 직접 배치)
+#define UDS_TIMER_MAX_WAIT_MSEC 500     ///< 만료 예정 타이머가 없을 때 최대 대기 시간(ms)
+
+struct UDS_TIMER_TAG;
+
+/**
+ * @brief 타이머 만료 콜백
+ *
+ * 타이머 휠 뮤텍스를 잡은 상태에서 호출되므로 같은 휠의 armUdsTimer()/cancelUdsTimer()나
+ * 서버 뮤텍스를 잡는 함수를 호출하면 안 됩니다.
+ *
+ * @return 0보다 크면 그 시간(ms) 뒤로 다시 등록, 그 외에는 해제
+ */
+typedef long long (*UDS_TIMER_FN)(struct UDS_TIMER_TAG *pstTimer);
+
+/**
+ * @brief 침입형(intrusive) 타이머 노드
+ *
+ * 소유 구조체(예: CLIENT)에 내장되며, 슬롯 목록에 이중 연결되어
+ * 등록과 취소가 O(1)입니다.
+ */
+typedef struct UDS_TIMER_TAG {
+    struct UDS_TIMER_TAG *pstNext;  ///< 슬롯 목록의 다음 노드
+    struct UDS_TIMER_TAG *pstPrev;  ///< 슬롯 목록의 이전 노드
+    unsigned long long ullExpireTick; ///< 만료 틱
+    int iArmed;                     ///< 등록 여부
+    UDS_TIMER_FN pfnExpire;         ///< 만료 콜백
+    void *pvArg;                    ///< 콜백 인자
+    int iArg;                       ///< 콜백 정수 인자 (예: 클라이언트 슬롯 인덱스)
+} UDS_TIMER;
+
+/**
+ * @brief 계층형 타이머 휠
+ *
+ * 0레벨은 한 슬롯이 1틱, 상위 레벨은 한 슬롯이 하위 레벨 한 바퀴를 나타냅니다.
+ * 0레벨이 한 바퀴 돌 때마다 상위 레벨의 슬롯 하나를 하위 레벨로 내려 보내므로,
+ * 틱마다 전체 타이머를 훑지 않습니다.
+ */
+typedef struct {
+    pthread_mutex_t mutex;          ///< 휠 보호용 뮤텍스
+    pthread_cond_t cond;            ///< 더 이른 타이머 등록 또는 종료 알림
+    unsigned long long ullStartUsec; ///< 0번 틱의 단조 시각(us)
+    unsigned long long ullCurrentTick; ///< 다음에 처리할 틱
+    unsigned long long ullWakeTick; ///< 대기 중인 스레드가 깨어날 예정 틱
+    int iArmedCount;                ///< 등록된 타이머 수
+    UDS_TIMER astSlots[UDS_TIMER_WHEEL_LEVELS][UDS_TIMER_WHEEL_SLOTS]; ///< 슬롯별 목록 헤드
+} UDS_TIMER_WHEEL;
+
+void initUdsTimerWheel(UDS_TIMER_WHEEL *pstWheel);
+void destroyUdsTimerWheel(UDS_TIMER_WHEEL *pstWheel);
+
+/**
+ * @brief 타이머 노드 초기화 (등록되지 않은 상태)
+ */
+void initUdsTimer(UDS_TIMER *pstTimer, UDS_TIMER_FN pfnExpire, void *pvArg, int iArg);
+
+/**
+ * @brief 타이머를 현재 시각부터 llDelayMsec 뒤에 만료되도록 등록
+ *
+ * 이미 등록된 타이머는 새 만료 시각으로 옮깁니다.
+ */
+void armUdsTimer(UDS_TIMER_WHEEL *pstWheel, UDS_TIMER *pstTimer, long long llDelayMsec);
+
+/**
+ * @brief 타이머 등록 취소
+ *
+ * 반환 후에는 해당 타이머의 콜백이 실행 중이지 않음이 보장됩니다.
+ */
+void cancelUdsTimer(UDS_TIMER_WHEEL *pstWheel, UDS_TIMER *pstTimer);
+
+/**
+ * @brief 현재 시각까지 휠을 진행하며 만료된 타이머의 콜백을 호출
+ *
+ * @return 만료된 타이머 수
+ */
+int advanceUdsTimerWheel(UDS_TIMER_WHEEL *pstWheel);
+
+/**
+ * @brief 다음 만료 가능 시각까지, 최대 iMaxMsec 동안 대기
+ *
+ * 더 이른 타이머가 등록되거나 wakeUdsTimerWheel()이 호출되면 일찍 반환합니다.
+ */
+void waitUdsTimerWheel(UDS_TIMER_WHEEL *pstWheel, int iMaxMsec);
+
+/**
+ * @brief waitUdsTimerWheel()에서 대기 중인 스레드를 깨움
+ */
+void wakeUdsTimerWheel(UDS_TIMER_WHEEL *pstWheel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -19,6 +19,26 @@ extern "C" {
  */
 int createUdsServerSocket(const char *pchSocketPath, int iMaxClients);
 
+/**
+ * @brief Unix 도메인 데이터그램(SOCK_DGRAM) 수신 소켓 생성
+ *
+ * 송신자 자격 증명(SCM_CREDENTIALS)을 함께 받을 수 있도록 SO_PASSCRED를 설정합니다.
+ *
+ * @param pchSocketPath Unix 도메인 소켓 파일 경로.
+ * @return 생성된 소켓 디스크립터, 실패 시 -1.
+ */
+int createUdsDgramServerSocket(const char *pchSocketPath);
+
+/**
+ * @brief Unix 도메인 데이터그램 수신 소켓에 연결된 송신용 소켓 생성
+ *
+ * 연결 후에는 udsSendMsg()로 데이터그램 하나씩 전송할 수 있습니다.
+ *
+ * @param pchSocketPath 데이터그램 수신 소켓 파일 경로.
+ * @return 연결된 소켓 디스크립터, 실패 시 -1.
+ */
+int createUdsDgramClientSocket(const char *pchSocketPath);
+
 /**
  * @brief Unix 도메인 소켓 서버에 연결
  *
@@ -65,6 +85,34 @@ int udsRecvMsg(int iSock, char *pchData, size_t iLength);
  */
 int udsRecvMsgTimeout(int iSock, char *pchData, size_t iLength, int iTimeoutMsec);
 
+/**
+ * @brief 데이터와 함께 파일 디스크립터를 전송 (SCM_RIGHTS)
+ *
+ * 부분 전송을 처리하며 iLength 바이트를 모두 보낼 때까지 반복합니다.
+ * 디스크립터는 첫 바이트에 붙여 한 번만 보냅니다.
+ *
+ * @param iSock 스트림 소켓 디스크립터
+ * @param pvData 전송할 데이터
+ * @param iLength 데이터 길이 (1 이상)
+ * @param iFd 함께 보낼 디스크립터 (음수면 데이터만 전송)
+ * @return 성공 시 iLength, 실패 시 -1
+ */
+int udsSendFd(int iSock, const void *pvData, size_t iLength, int iFd);
+
+/**
+ * @brief udsSendFd()로 보낸 데이터와 파일 디스크립터를 수신
+ *
+ * iLength 바이트를 모두 받을 때까지 반복합니다.
+ * 받은 디스크립터에는 FD_CLOEXEC가 설정됩니다.
+ *
+ * @param iSock 스트림 소켓 디스크립터
+ * @param pvData 수신 버퍼
+ * @param iLength 받을 길이
+ * @param piFd 받은 디스크립터를 저장할 위치 (없으면 -1, NULL이면 받은 디스크립터를 닫음)
+ * @return 성공 시 iLength, 데이터 없이 연결 종료 시 0, 실패 시 -1
+ */
+int udsRecvFd(int iSock, void *pvData, size_t iLength, int *piFd);
+
 /**
  * @brief Unix 도메인 소켓을 종료합니다.
  *
@@ -0,0 +1,202 @@
+/**
+ * @file capture.c
+ * @brief 수신 트래픽 캡처 로그
+ *
+ * 이 파일은 클라이언트가 보낸 데이터를 시각, 클라이언트 ID, 크기와 함께
+ * mmap으로 매핑한 추가 전용 바이너리 로그에 기록하는 루틴과,
+ * 재생 도구가 이를 순서대로 읽는 루틴을 정의합니다.
+ */
+
+#include "uds-capture.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define UDS_CAPTURE_HEADER_SIZE sizeof(UDS_CAPTURE_FILE_HEADER)
+#define UDS_CAPTURE_RECORD_SPAN(iLength) \
+    ((sizeof(UDS_CAPTURE_RECORD) + (size_t)(iLength) + UDS_CAPTURE_ALIGN - 1) & ~(size_t)(UDS_CAPTURE_ALIGN - 1))
+
+static unsigned long long getUdsCaptureNsec(clockid_t iClock)
+{
+    struct timespec stNow;
+    clock_gettime(iClock, &stNow);
+    return (unsigned long long)stNow.tv_sec * 1000000000ULL + stNow.tv_nsec;
+}
+
+int openUdsCapture(UDS_CAPTURE *pstCapture, const char *pchPath, unsigned long long ullMaxBytes)
+{
+    UDS_CAPTURE_FILE_HEADER stHeader;
+
+    memset(pstCapture, 0, sizeof(UDS_CAPTURE));
+    pstCapture->iFd = -1;
+    pstCapture->ullMaxBytes = ullMaxBytes > 0 ? ullMaxBytes : UDS_CAPTURE_MAX_BYTES;
+    pstCapture->ullFileBytes = pstCapture->ullMaxBytes < UDS_CAPTURE_GROW_BYTES ? pstCapture->ullMaxBytes : UDS_CAPTURE_GROW_BYTES;
+
+    pstCapture->iFd = open(pchPath, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (pstCapture->iFd < 0) {
+        perror("Capture open failed");
+        return -1;
+    }
+    if (ftruncate(pstCapture->iFd, UDS_CAPTURE_HEADER_SIZE + pstCapture->ullFileBytes) != 0) {
+        perror("Capture ftruncate failed");
+        close(pstCapture->iFd);
+        return -1;
+    }
+    // 최대 크기만큼 주소 공간을 미리 잡아 두어, 파일이 늘어나도 다시 매핑하지 않는다
+    void *pvBase = mmap(NULL, UDS_CAPTURE_HEADER_SIZE + pstCapture->ullMaxBytes, PROT_READ | PROT_WRITE, MAP_SHARED, pstCapture->iFd, 0);
+    if (pvBase == MAP_FAILED) {
+        perror("Capture mmap failed");
+        close(pstCapture->iFd);
+        return -1;
+    }
+
+    memset(&stHeader, 0, sizeof(stHeader));
+    memcpy(stHeader.chMagic, UDS_CAPTURE_MAGIC, sizeof(stHeader.chMagic));
+    stHeader.uiVersion = UDS_CAPTURE_VERSION;
+    stHeader.uiHeaderSize = UDS_CAPTURE_HEADER_SIZE;
+    stHeader.ullStartRealtimeNsec = getUdsCaptureNsec(CLOCK_REALTIME);
+    memcpy(pvBase, &stHeader, sizeof(stHeader));
+
+    pthread_mutex_init(&pstCapture->mutex, NULL);
+    pstCapture->ullStartNsec = getUdsCaptureNsec(CLOCK_MONOTONIC);
+    pstCapture->pchBase = (char *)pvBase;
+    return 0;
+}
+
+void closeUdsCapture(UDS_CAPTURE *pstCapture)
+{
+    if (pstCapture->pchBase == NULL)
+        return;
+
+    unsigned long long ullDataBytes = pstCapture->ullOffset < pstCapture->ullFileBytes ? pstCapture->ullOffset : pstCapture->ullFileBytes;
+    ((UDS_CAPTURE_FILE_HEADER *)pstCapture->pchBase)->ullDataBytes = ullDataBytes;
+    munmap(pstCapture->pchBase, UDS_CAPTURE_HEADER_SIZE + pstCapture->ullMaxBytes);
+    if (ftruncate(pstCapture->iFd, UDS_CAPTURE_HEADER_SIZE + ullDataBytes) != 0)
+        perror("Capture ftruncate failed");
+    close(pstCapture->iFd);
+    pthread_mutex_destroy(&pstCapture->mutex);
+    fprintf(stderr, "[Capture] %llu records, %llu bytes, %llu dropped\n",
+            pstCapture->ullRecords, ullDataBytes, pstCapture->ullDropped);
+    pstCapture->pchBase = NULL;
+    pstCapture->iFd = -1;
+}
+
+/**
+ * @brief 예약한 영역까지 파일을 늘림
+ *
+ * @return 기록할 수 있으면 1, 최대 크기나 디스크 한도에 걸리면 0
+ */
+static int growUdsCapture(UDS_CAPTURE *pstCapture, unsigned long long ullEnd)
+{
+    int iOk = 1;
+
+    pthread_mutex_lock(&pstCapture->mutex);
+    while (iOk && pstCapture->ullFileBytes < ullEnd) {
+        unsigned long long ullNewBytes = pstCapture->ullFileBytes + UDS_CAPTURE_GROW_BYTES;
+        if (ullNewBytes > pstCapture->ullMaxBytes)
+            ullNewBytes = pstCapture->ullMaxBytes;
+        if (ullNewBytes < ullEnd || ftruncate(pstCapture->iFd, UDS_CAPTURE_HEADER_SIZE + ullNewBytes) != 0) {
+            iOk = 0;
+            break;
+        }
+        __atomic_store_n(&pstCapture->ullFileBytes, ullNewBytes, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&pstCapture->mutex);
+    return iOk;
+}
+
+void captureUdsRecord(UDS_CAPTURE *pstCapture, int iType, int iClientId, const void *pvData, int iLength)
+{
+    if (pstCapture->pchBase == NULL || iLength < 0)
+        return;
+    if (__atomic_load_n(&pstCapture->iFull, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&pstCapture->ullDropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    unsigned long long ullSpan = UDS_CAPTURE_RECORD_SPAN(iLength);
+    unsigned long long ullStart = __atomic_fetch_add(&pstCapture->ullOffset, ullSpan, __ATOMIC_RELAXED);
+    unsigned long long ullEnd = ullStart + ullSpan;
+    if (ullEnd > __atomic_load_n(&pstCapture->ullFileBytes, __ATOMIC_ACQUIRE) && !growUdsCapture(pstCapture, ullEnd)) {
+        // 예약한 자리는 타입이 0으로 남아 읽는 쪽이 여기서 멈추므로, 이후 레코드도 모두 버린다
+        __atomic_store_n(&pstCapture->iFull, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&pstCapture->ullDropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    UDS_CAPTURE_RECORD *pstRecord = (UDS_CAPTURE_RECORD *)(pstCapture->pchBase + UDS_CAPTURE_HEADER_SIZE + ullStart);
+    pstRecord->uiClientId = (unsigned int)iClientId;
+    pstRecord->uiLength = (unsigned int)iLength;
+    pstRecord->uiReserved = 0;
+    pstRecord->ullTimeNsec = getUdsCaptureNsec(CLOCK_MONOTONIC) - pstCapture->ullStartNsec;
+    if (iLength > 0)
+        memcpy(pstRecord + 1, pvData, iLength);
+    __atomic_store_n(&pstRecord->uiType, (unsigned int)iType, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&pstCapture->ullRecords, 1, __ATOMIC_RELAXED);
+}
+
+int openUdsCaptureLog(UDS_CAPTURE_LOG *pstLog, const char *pchPath)
+{
+    struct stat stStat;
+
+    memset(pstLog, 0, sizeof(UDS_CAPTURE_LOG));
+    pstLog->iFd = open(pchPath, O_RDONLY | O_CLOEXEC);
+    if (pstLog->iFd < 0) {
+        perror("Capture log open failed");
+        return -1;
+    }
+    if (fstat(pstLog->iFd, &stStat) != 0 || (size_t)stStat.st_size < UDS_CAPTURE_HEADER_SIZE) {
+        fprintf(stderr, "Capture log too short: %s\n", pchPath);
+        close(pstLog->iFd);
+        return -1;
+    }
+    void *pvBase = mmap(NULL, stStat.st_size, PROT_READ, MAP_SHARED, pstLog->iFd, 0);
+    if (pvBase == MAP_FAILED) {
+        perror("Capture log mmap failed");
+        close(pstLog->iFd);
+        return -1;
+    }
+
+    const UDS_CAPTURE_FILE_HEADER *pstHeader = (const UDS_CAPTURE_FILE_HEADER *)pvBase;
+    if (memcmp(pstHeader->chMagic, UDS_CAPTURE_MAGIC, sizeof(pstHeader->chMagic)) != 0
+     || pstHeader->uiVersion != UDS_CAPTURE_VERSION || pstHeader->uiHeaderSize != UDS_CAPTURE_HEADER_SIZE) {
+        fprintf(stderr, "Not a capture log: %s\n", pchPath);
+        munmap(pvBase, stStat.st_size);
+        close(pstLog->iFd);
+        return -1;
+    }
+    pstLog->pchBase = (const char *)pvBase;
+    pstLog->iSize = stStat.st_size;
+    pstLog->ullStartRealtimeNsec = pstHeader->ullStartRealtimeNsec;
+    return 0;
+}
+
+const UDS_CAPTURE_RECORD* nextUdsCaptureRecord(const UDS_CAPTURE_LOG *pstLog, size_t *piOffset)
+{
+    size_t iPos = UDS_CAPTURE_HEADER_SIZE + *piOffset;
+
+    if (iPos + sizeof(UDS_CAPTURE_RECORD) > pstLog->iSize)
+        return NULL;
+    const UDS_CAPTURE_RECORD *pstRecord = (const UDS_CAPTURE_RECORD *)(pstLog->pchBase + iPos);
+    if (__atomic_load_n(&pstRecord->uiType, __ATOMIC_ACQUIRE) == 0)
+        return NULL;
+    size_t iSpan = UDS_CAPTURE_RECORD_SPAN(pstRecord->uiLength);
+    if (iPos + iSpan > pstLog->iSize)
+        return NULL;
+    *piOffset += iSpan;
+    return pstRecord;
+}
+
+void closeUdsCaptureLog(UDS_CAPTURE_LOG *pstLog)
+{
+    if (pstLog->pchBase != NULL)
+        munmap((void *)pstLog->pchBase, pstLog->iSize);
+    if (pstLog->iFd >= 0)
+        close(pstLog->iFd);
+    pstLog->pchBase = NULL;
+    pstLog->iFd = -1;
+}
@@ -8,30 +8,53 @@
 
 #include "uds-server.h"
 #include "uds.h"
+#include <poll.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 void* connectionManagerThread(void* arg) 
 {
-    UDS_SERVER* pstUdsServer = (UDS_SERVER *)arg;
+    UDS_SERVER_THREAD* pstThread = (UDS_SERVER_THREAD *)arg;
+    UDS_SERVER* pstUdsServer = pstThread->pstServer;
     int iMaxClients = pstUdsServer->iMaxClients;
-    while (1) {
+    struct pollfd stPollFds[2];
+
+    // 핸드오프 시 공유 중인 리스닝 소켓을 shutdown()하지 않고도 멈출 수 있도록 wake 파이프를 함께 감시한다
+    stPollFds[0].fd = pstUdsServer->iServerSock;
+    stPollFds[0].events = POLLIN;
+    stPollFds[1].fd = pstThread->aiWakeFd[0];
+    stPollFds[1].events = POLLIN;
+    while (pstUdsServer->iRunning) {
+        if (poll(stPollFds, 2, 500) <= 0)
+            continue;
+        if (stPollFds[1].revents & POLLIN) {
+            char chDrain[64];
+            while (read(pstThread->aiWakeFd[0], chDrain, sizeof(chDrain)) > 0)
+                ;
+            continue;
+        }
         int iClientFd = acceptUdsClient(pstUdsServer->iServerSock);
         if (iClientFd >= 0) {
+            int iSlot = -1;
             pthread_mutex_lock(&pstUdsServer->mutex);
             for (int i = 0; i < iMaxClients; ++i) {                
                 if (!pstUdsServer->pstClients[i].iActive) {
-                    pstUdsServer->pstClients[i].iSock = iClientFd;                    
-                    queueInit(&(pstUdsServer->pstClients[i].stRecvQueue), 10);
-                    queueInit(&(pstUdsServer->pstClients[i].stSendQueue), 10);
-                    pstUdsServer->pstClients[i].iActive = 1;
-                    pstUdsServer->iClientCount++;
+                    activateUdsClient(pstUdsServer, i, iClientFd);
                     printf("[Connect] Client %d connected (fd: %d), count : %d\n", i, iClientFd, pstUdsServer->iClientCount);
+                    iSlot = i;
                     break;
                 }                
             }
             pthread_mutex_unlock(&pstUdsServer->mutex);
+            if (iSlot >= 0) {
+                wakeUdsRecvThread(pstUdsServer, iSlot);
+            } else {
+                fprintf(stderr, "[Connect] No free slot, closing fd %d\n", iClientFd);
+                __atomic_add_fetch(&pstUdsServer->stStats.ullRejects, 1, __ATOMIC_RELAXED);
+                close(iClientFd);
+            }
         } else {
             usleep(5*1000); // 5ms
         }
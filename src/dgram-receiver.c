@@ -0,0 +1,280 @@
+/**
+ * @file dgram-receiver.c
+ * @brief UDS 데이터그램 수신 스레드
+ *
+ * 이 파일은 연결 없이 들어오는 데이터그램을 recvmmsg()로 일괄 수신하고,
+ * 송신자 정보를 붙여 서버의 데이터그램 수신 큐에 저장하는
+ * 스레드 함수와, 큐에서 메시지를 꺼내는 소비자 API 및 수신 버퍼 풀을 정의합니다.
+ * 캡처 모드에서는 받은 데이터그램을 송신자 PID와 함께 UDS_CAPTURE_DGRAM 레코드로 기록합니다.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "uds-server.h"
+#include "uds.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+void initUdsDgramPool(UDS_DGRAM_POOL *pstPool, int iMaxFree)
+{
+    pthread_mutex_init(&pstPool->mutex, NULL);
+    pstPool->pstFree = NULL;
+    pstPool->iFreeCount = 0;
+    pstPool->iMaxFree = iMaxFree;
+}
+
+void destroyUdsDgramPool(UDS_DGRAM_POOL *pstPool)
+{
+    pthread_mutex_lock(&pstPool->mutex);
+    while (pstPool->pstFree != NULL) {
+        UDS_DGRAM_MSG *pstDgram = pstPool->pstFree;
+        pstPool->pstFree = pstDgram->pstNext;
+        free(pstDgram);
+    }
+    pstPool->iFreeCount = 0;
+    pthread_mutex_unlock(&pstPool->mutex);
+    pthread_mutex_destroy(&pstPool->mutex);
+}
+
+static UDS_DGRAM_MSG* allocUdsDgramMsg(UDS_DGRAM_POOL *pstPool)
+{
+    UDS_DGRAM_MSG *pstDgram = NULL;
+
+    pthread_mutex_lock(&pstPool->mutex);
+    if (pstPool->pstFree != NULL) {
+        pstDgram = pstPool->pstFree;
+        pstPool->pstFree = pstDgram->pstNext;
+        pstPool->iFreeCount--;
+    }
+    pthread_mutex_unlock(&pstPool->mutex);
+
+    // 어떤 길이든 담을 수 있도록 최대 크기로 잡아 두어야 재사용할 수 있다
+    if (pstDgram == NULL)
+        pstDgram = (UDS_DGRAM_MSG *)malloc(sizeof(UDS_DGRAM_MSG) + UDS_MAX_DATA_SIZE);
+    return pstDgram;
+}
+
+static void freeUdsDgramMsg(UDS_DGRAM_POOL *pstPool, UDS_DGRAM_MSG *pstDgram)
+{
+    pthread_mutex_lock(&pstPool->mutex);
+    if (pstPool->iFreeCount < pstPool->iMaxFree) {
+        pstDgram->pstNext = pstPool->pstFree;
+        pstPool->pstFree = pstDgram;
+        pstPool->iFreeCount++;
+        pstDgram = NULL;
+    }
+    pthread_mutex_unlock(&pstPool->mutex);
+    free(pstDgram);
+}
+
+void releaseUdsDgramMsg(UDS_SERVER *pstUdsServer, UDS_DGRAM_MSG *pstMsg)
+{
+    if (pstMsg == NULL)
+        return;
+    releaseUdsDgramMemory(pstUdsServer, UDS_DGRAM_BUFFER_SIZE);
+    freeUdsDgramMsg(&pstUdsServer->stDgramPool, pstMsg);
+}
+
+void discardUdsDgramMsgs(UDS_SERVER *pstUdsServer)
+{
+    void *pvData = NULL;
+
+    while (queuePop(&pstUdsServer->stDgramQueue, &pvData) > 0 && pvData != NULL)
+        releaseUdsDgramMsg(pstUdsServer, (UDS_DGRAM_MSG *)pvData);
+}
+
+/**
+ * @brief recvmmsg() 일괄 수신 상태
+ *
+ * iovec은 풀에서 가져온 UDS_DGRAM_MSG의 데이터 영역을 바로 가리키므로, 받은 데이터를
+ * 다시 복사하지 않고 버퍼째 큐에 넘깁니다. 넘긴 자리만 다음 수신 전에 새 버퍼로 채웁니다.
+ */
+typedef struct {
+    struct mmsghdr stMsgs[UDS_DGRAM_BATCH];
+    struct iovec stIovs[UDS_DGRAM_BATCH];
+    struct sockaddr_un stAddrs[UDS_DGRAM_BATCH];
+    char chCtrl[UDS_DGRAM_BATCH][CMSG_SPACE(sizeof(struct ucred))];
+    UDS_DGRAM_MSG *pstBufs[UDS_DGRAM_BATCH];
+} DGRAM_BATCH;
+
+/**
+ * @brief 빈 자리에 버퍼를 채우고 헤더를 초기화
+ *
+ * @return 이번에 수신할 수 있는 메시지 수 (버퍼를 할당하지 못하면 그 앞까지)
+ */
+static int resetDgramBatch(DGRAM_BATCH *pstBatch, UDS_DGRAM_POOL *pstPool)
+{
+    int i;
+
+    for (i = 0; i < UDS_DGRAM_BATCH; ++i) {
+        if (pstBatch->pstBufs[i] == NULL && (pstBatch->pstBufs[i] = allocUdsDgramMsg(pstPool)) == NULL)
+            break;
+        pstBatch->stIovs[i].iov_base = pstBatch->pstBufs[i]->chData;
+        pstBatch->stIovs[i].iov_len = UDS_MAX_DATA_SIZE;
+        memset(&pstBatch->stMsgs[i].msg_hdr, 0, sizeof(struct msghdr));
+        pstBatch->stMsgs[i].msg_hdr.msg_name = &pstBatch->stAddrs[i];
+        pstBatch->stMsgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_un);
+        pstBatch->stMsgs[i].msg_hdr.msg_iov = &pstBatch->stIovs[i];
+        pstBatch->stMsgs[i].msg_hdr.msg_iovlen = 1;
+        pstBatch->stMsgs[i].msg_hdr.msg_control = pstBatch->chCtrl[i];
+        pstBatch->stMsgs[i].msg_hdr.msg_controllen = sizeof(pstBatch->chCtrl[i]);
+    }
+    return i;
+}
+
+/**
+ * @brief 데이터를 받은 버퍼에 송신자 정보와 길이를 채움 (데이터는 이미 chData에 있음)
+ */
+static void buildDgramMsg(UDS_DGRAM_MSG *pstDgram, struct mmsghdr *pstMsg)
+{
+    struct msghdr *pstHdr = &pstMsg->msg_hdr;
+
+    // 구조체 끝의 채움 바이트가 chData와 겹칠 수 있으므로 데이터 앞까지만 지운다
+    memset(pstDgram, 0, offsetof(UDS_DGRAM_MSG, chData));
+    for (struct cmsghdr *pstCmsg = CMSG_FIRSTHDR(pstHdr); pstCmsg != NULL; pstCmsg = CMSG_NXTHDR(pstHdr, pstCmsg)) {
+        if (pstCmsg->cmsg_level == SOL_SOCKET && pstCmsg->cmsg_type == SCM_CREDENTIALS) {
+            struct ucred stCred;
+            memcpy(&stCred, CMSG_DATA(pstCmsg), sizeof(stCred));
+            pstDgram->iPid = stCred.pid;
+            pstDgram->uiUid = stCred.uid;
+            pstDgram->uiGid = stCred.gid;
+        }
+    }
+
+    struct sockaddr_un *pstAddr = (struct sockaddr_un *)pstHdr->msg_name;
+    socklen_t uiPathLen = pstHdr->msg_namelen > offsetof(struct sockaddr_un, sun_path)
+                        ? pstHdr->msg_namelen - offsetof(struct sockaddr_un, sun_path) : 0;
+    if (uiPathLen > 0 && pstAddr->sun_path[0] != '\0') {
+        if (uiPathLen >= sizeof(pstDgram->chSenderPath))
+            uiPathLen = sizeof(pstDgram->chSenderPath) - 1;
+        memcpy(pstDgram->chSenderPath, pstAddr->sun_path, uiPathLen);
+    }
+
+    pstDgram->iLength = (int)pstMsg->msg_len;
+}
+
+void* dgramRecvThread(void* arg)
+{
+    UDS_SERVER_THREAD* pstThread = (UDS_SERVER_THREAD *)arg;
+    UDS_SERVER* pstUdsServer = pstThread->pstServer;
+    DGRAM_BATCH *pstBatch = (DGRAM_BATCH *)calloc(1, sizeof(DGRAM_BATCH));
+    if (pstBatch == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return NULL;
+    }
+
+    while (pstUdsServer->iRunning) {
+        int iReady = resetDgramBatch(pstBatch, &pstUdsServer->stDgramPool);
+        if (iReady == 0) {
+            fprintf(stderr, "Memory allocation failed\n");
+            usleep(10 * 1000);
+            continue;
+        }
+        int iCount = recvmmsg(pstUdsServer->iDgramSock, pstBatch->stMsgs, iReady, MSG_WAITFORONE, NULL);
+        if (iCount < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("recvmmsg failed");
+            break;
+        }
+        // stopUdsServer()나 핸드오프의 shutdown()으로 깨어나면 빈 메시지가 돌아오므로 기록하지 않는다
+        if (!pstUdsServer->iRunning)
+            break;
+
+        int iPushed = 0;
+        for (int i = 0; i < iCount; ++i) {
+            // 버리는 데이터그램의 버퍼는 그 자리에 두었다가 다음 수신에 다시 쓴다
+            if (pstBatch->stMsgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                fprintf(stderr, "### DROP %s():%d truncated datagram ###\n", __func__, __LINE__);
+                continue;
+            }
+            if (!reserveUdsDgramMemory(pstUdsServer, UDS_DGRAM_BUFFER_SIZE))
+                continue;
+            UDS_DGRAM_MSG *pstDgram = pstBatch->pstBufs[i];
+            pstBatch->pstBufs[i] = NULL;
+            buildDgramMsg(pstDgram, &pstBatch->stMsgs[i]);
+            captureUdsRecord(&pstUdsServer->stCapture, UDS_CAPTURE_DGRAM, pstDgram->iPid, pstDgram->chData, pstDgram->iLength);
+            if (queuePush(&pstUdsServer->stDgramQueue, pstDgram, sizeof(UDS_DGRAM_MSG) + pstDgram->iLength) == 0) {
+                fprintf(stderr, "### FAIL %s():%d dgram queue full ###\n", __func__, __LINE__);
+                releaseUdsDgramMsg(pstUdsServer, pstDgram);
+                continue;
+            }
+            iPushed = 1;
+        }
+        if (iPushed) {
+            // 묶음마다 한 번만 알린다. 소비자는 뮤텍스를 잡은 채 큐를 확인하고 잠들므로 알림을 놓치지 않는다
+            pthread_mutex_lock(&pstUdsServer->mutex);
+            __atomic_add_fetch(&pstUdsServer->ulDgramSeq, 1, __ATOMIC_RELEASE);
+            if (pstUdsServer->iDgramWaiters > 0)
+                pthread_cond_broadcast(&pstUdsServer->stDgramCond);
+            pthread_mutex_unlock(&pstUdsServer->mutex);
+        }
+    }
+    for (int i = 0; i < UDS_DGRAM_BATCH; ++i) {
+        if (pstBatch->pstBufs[i] != NULL)
+            freeUdsDgramMsg(&pstUdsServer->stDgramPool, pstBatch->pstBufs[i]);
+    }
+    free(pstBatch);
+    return NULL;
+}
+
+int udsServerRecvDgram(UDS_SERVER *pstUdsServer, UDS_DGRAM_MSG **ppstMsg, int iTimeoutMsec)
+{
+    void *pvData = NULL;
+    int iSize = 0;
+
+    *ppstMsg = NULL;
+    if (enterUdsServerApi(pstUdsServer) != 0)
+        return UDS_HANDING_OFF;
+    if (pstUdsServer->iDgramSock < 0) {
+        leaveUdsServerApi(pstUdsServer);
+        return -1;
+    }
+
+    unsigned long long ullStartUsec = getUdsMonotonicUsec();
+    unsigned long long ullSpinEndUsec = ullStartUsec + pstUdsServer->stConfig.iBusyPollUsec;
+    unsigned long long ullEndUsec = ullStartUsec + (unsigned long long)iTimeoutMsec * 1000ULL;
+    if (ullSpinEndUsec > ullEndUsec)
+        ullSpinEndUsec = ullEndUsec;
+
+    pthread_mutex_lock(&pstUdsServer->mutex);
+    while ((iSize = queuePop(&pstUdsServer->stDgramQueue, &pvData)) <= 0) {
+        unsigned long long ullNowUsec = getUdsMonotonicUsec();
+        if (ullNowUsec >= ullEndUsec || pstUdsServer->iHandingOff)
+            break;
+        if (ullNowUsec < ullSpinEndUsec) {
+            // 바쁜 대기 구간: 뮤텍스를 놓고 데이터그램 순번이 바뀔 때까지만 확인한다
+            unsigned long ulSeq = __atomic_load_n(&pstUdsServer->ulDgramSeq, __ATOMIC_ACQUIRE);
+            pthread_mutex_unlock(&pstUdsServer->mutex);
+            while (__atomic_load_n(&pstUdsServer->ulDgramSeq, __ATOMIC_ACQUIRE) == ulSeq
+                && getUdsMonotonicUsec() < ullSpinEndUsec)
+                udsCpuRelax();
+            pthread_mutex_lock(&pstUdsServer->mutex);
+            continue;
+        }
+        struct timespec stDeadline;
+        clock_gettime(CLOCK_REALTIME, &stDeadline);
+        unsigned long long ullNsec = stDeadline.tv_nsec + (ullEndUsec - ullNowUsec) * 1000ULL;
+        stDeadline.tv_sec += ullNsec / 1000000000ULL;
+        stDeadline.tv_nsec = ullNsec % 1000000000ULL;
+        pstUdsServer->iDgramWaiters++;
+        pthread_cond_timedwait(&pstUdsServer->stDgramCond, &pstUdsServer->mutex, &stDeadline);
+        pstUdsServer->iDgramWaiters--;
+    }
+    int iHandingOff = pstUdsServer->iHandingOff;
+    pthread_mutex_unlock(&pstUdsServer->mutex);
+    leaveUdsServerApi(pstUdsServer);
+
+    if (iSize > 0 && pvData != NULL) {
+        *ppstMsg = (UDS_DGRAM_MSG *)pvData;
+        return (*ppstMsg)->iLength;
+    }
+    return iHandingOff ? UDS_HANDING_OFF : UDS_TIME_OUT;
+}
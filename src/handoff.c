@@ -0,0 +1,507 @@
+/**
+ * @file handoff.c
+ * @brief 무중단 재시작을 위한 서버 핸드오프
+ *
+ * 이 파일은 실행 중인 서버의 리스닝 소켓과 연결된 클라이언트 소켓을
+ * 제어용 Unix 도메인 소켓과 SCM_RIGHTS로 후속 프로세스에 넘기는 루틴과,
+ * 이를 받아 같은 슬롯 번호로 서버를 복원하는 루틴을 정의합니다.
+ *
+ * 제어 소켓 프로토콜 (같은 호스트이므로 네이티브 바이트 순서):
+ *   UDS_HANDOFF_HEADER + 리스닝 소켓
+ *   클라이언트마다 UDS_HANDOFF_CLIENT + 클라이언트 소켓, 병합 버퍼 내용,
+ *     수신 메시지 iRecvCount개와 송신 메시지 iSendCount개 (각각 int 길이 + 데이터)
+ *   iSlot이 -1인 UDS_HANDOFF_CLIENT (끝 표시)
+ *   후속 프로세스가 복원을 마치면 1바이트 응답
+ *
+ * 양쪽 모두 SO_PEERCRED로 상대가 같은 UID인지 확인한 뒤에만 주고받습니다.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "uds-server.h"
+#include "uds.h"
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#define UDS_HANDOFF_MAGIC       0x55445348  ///< "UDSH"
+#define UDS_HANDOFF_VERSION     1
+#define UDS_HANDOFF_ACK         1           ///< 복원 완료 응답
+#define UDS_HANDOFF_MAX_MSG     (1 << 30)   ///< 받을 수 있는 메시지 하나의 최대 크기
+
+typedef struct {
+    unsigned int uiMagic;
+    unsigned int uiVersion;
+    int iMaxClients;
+    int iClientCount;
+} UDS_HANDOFF_HEADER;
+
+typedef struct {
+    int iSlot;               ///< 슬롯 번호 (-1이면 끝)
+    int iRecvCount;          ///< 뒤따르는 수신 메시지 수
+    int iSendCount;          ///< 뒤따르는 송신 메시지 수
+    int iCoalesceMaxBytes;
+    int iCoalesceDelayUsec;
+    int iCoalesceLen;        ///< 뒤따르는 병합 버퍼 바이트 수
+    int iHeaderLen;          ///< 스트림 모드: 수신 중이던 길이 헤더 바이트 수
+    unsigned char uchHeader[UDS_STREAM_HEADER_SIZE];
+    unsigned long long ullSkip; ///< 스트림 모드: 새 프로세스가 버려야 할 남은 프레임 바이트 수
+} UDS_HANDOFF_CLIENT;
+
+typedef struct {
+    void *pvData;
+    int iSize;
+} UDS_HANDOFF_ITEM;
+
+/**
+ * @brief 이전 프로세스가 넘기는 동안 큐에서 꺼내 둔 메시지
+ *
+ * 후속 프로세스의 응답을 받기 전까지는 해제하지 않고, 실패하면 큐에 되돌립니다.
+ */
+typedef struct {
+    UDS_HANDOFF_ITEM *pstRecv;
+    int iRecvCount;
+    UDS_HANDOFF_ITEM *pstSend;
+    int iSendCount;
+} UDS_HANDOFF_SAVED;
+
+/**
+ * @brief 제어 소켓 상대 프로세스가 같은 UID인지 확인
+ *
+ * @return 같으면 0, 다르거나 확인할 수 없으면 -1
+ */
+static int checkHandoffPeer(int iCtrl)
+{
+    struct ucred stCred;
+    socklen_t uiLen = sizeof(stCred);
+
+    if (getsockopt(iCtrl, SOL_SOCKET, SO_PEERCRED, &stCred, &uiLen) != 0) {
+        perror("[Handoff] SO_PEERCRED failed");
+        return -1;
+    }
+    if (stCred.uid != geteuid()) {
+        fprintf(stderr, "[Handoff] Rejecting peer pid %d uid %u\n", (int)stCred.pid, (unsigned int)stCred.uid);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 공개 API를 막고 이미 들어와 있던 호출이 모두 빠져나올 때까지 기다림
+ */
+static void blockUdsServerApi(UDS_SERVER *pstUdsServer)
+{
+    pthread_mutex_lock(&pstUdsServer->mutex);
+    __atomic_store_n(&pstUdsServer->iHandingOff, 1, __ATOMIC_SEQ_CST);
+    // udsServerRecv()에서 잠든 소비자를 깨워 UDS_HANDING_OFF로 돌려보낸다
+    for (int i = 0; i < pstUdsServer->iMaxClients; ++i) {
+        if (pstUdsServer->pstClients[i].iRecvWaiters > 0)
+            pthread_cond_broadcast(&pstUdsServer->pstClients[i].stRecvCond);
+    }
+    if (pstUdsServer->iDgramWaiters > 0)
+        pthread_cond_broadcast(&pstUdsServer->stDgramCond);
+    pthread_mutex_unlock(&pstUdsServer->mutex);
+    while (__atomic_load_n(&pstUdsServer->iApiCallers, __ATOMIC_SEQ_CST) > 0)
+        usleep(100);
+}
+
+static int appendHandoffItem(UDS_HANDOFF_ITEM **ppstItems, int *piCount, void *pvData, int iSize)
+{
+    int iCount = *piCount;
+
+    // 용량은 16부터 두 배씩 늘리므로 개수가 0이거나 16 이상의 2의 거듭제곱일 때만 늘린다
+    if (iCount == 0 || (iCount >= 16 && (iCount & (iCount - 1)) == 0)) {
+        int iNewCapacity = iCount ? iCount * 2 : 16;
+        UDS_HANDOFF_ITEM *pstItems = (UDS_HANDOFF_ITEM *)realloc(*ppstItems, iNewCapacity * sizeof(UDS_HANDOFF_ITEM));
+        if (pstItems == NULL)
+            return -1;
+        *ppstItems = pstItems;
+    }
+    (*ppstItems)[iCount].pvData = pvData;
+    (*ppstItems)[iCount].iSize = iSize;
+    *piCount = iCount + 1;
+    return 0;
+}
+
+static int drainHandoffQueue(QUEUE *pstQueue, UDS_HANDOFF_ITEM **ppstItems, int *piCount)
+{
+    void *pvData = NULL;
+    int iSize;
+
+    *ppstItems = NULL;
+    *piCount = 0;
+    while ((iSize = queuePop(pstQueue, &pvData)) > 0 && pvData != NULL) {
+        if (appendHandoffItem(ppstItems, piCount, pvData, iSize) != 0) {
+            queuePush(pstQueue, pvData, iSize);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief udsServerSend()로 넣은 메시지를 송신 큐 메시지 뒤에 붙임
+ *
+ * 실패 시 되돌릴 수 있도록 송신 큐 메시지와 같은 형태(데이터만 담은 버퍼, 클라이언트별 집계)로 옮깁니다.
+ */
+static int drainHandoffSendMsgs(UDS_SERVER *pstUdsServer, int iClientIndex, UDS_HANDOFF_ITEM **ppstItems, int *piCount)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+    UDS_SEND_MSG *pstMsg;
+
+    while ((pstMsg = popUdsSendMsg(pstUdsServer, iClientIndex)) != NULL) {
+        int iSize = pstMsg->iLength;
+        // 데이터를 헤더 자리로 당겨 같은 블록을 송신 큐 메시지처럼 넘긴다
+        memmove(pstMsg, pstMsg->chData, iSize);
+        if (appendHandoffItem(ppstItems, piCount, pstMsg, iSize) != 0) {
+            free(pstMsg);
+            return -1;
+        }
+        pstClient->ullSendQueuedBytes += iSize;
+        __atomic_add_fetch(&pstUdsServer->stStats.ullQueuedBytes, iSize, __ATOMIC_RELAXED);
+    }
+    return 0;
+}
+
+/**
+ * @brief 핸드오프 실패 시 꺼내 둔 메시지를 다시 큐에 넣음
+ *
+ * 넣지 못해 버리는 메시지는 꺼낼 때 집계된 예산도 돌려준다.
+ */
+static void restoreHandoffQueue(UDS_SERVER *pstUdsServer, int iClientIndex, int iDirection,
+                                UDS_HANDOFF_ITEM *pstItems, int iCount)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+    QUEUE *pstQueue = iDirection == UDS_QUEUE_RECV ? &pstClient->stRecvQueue : &pstClient->stSendQueue;
+
+    for (int i = 0; i < iCount; ++i) {
+        if (!queuePush(pstQueue, pstItems[i].pvData, pstItems[i].iSize)) {
+            releaseUdsMemory(pstUdsServer, iClientIndex, iDirection, pstItems[i].iSize);
+            free(pstItems[i].pvData);
+        }
+    }
+    free(pstItems);
+}
+
+static void freeHandoffItems(UDS_HANDOFF_ITEM *pstItems, int iCount)
+{
+    for (int i = 0; i < iCount; ++i)
+        free(pstItems[i].pvData);
+    free(pstItems);
+}
+
+static int sendHandoffItems(int iCtrl, const UDS_HANDOFF_ITEM *pstItems, int iCount)
+{
+    for (int i = 0; i < iCount; ++i) {
+        if (udsSendFd(iCtrl, &pstItems[i].iSize, sizeof(int), -1) < 0
+         || udsSendFd(iCtrl, pstItems[i].pvData, pstItems[i].iSize, -1) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int sendHandoffClient(UDS_SERVER *pstUdsServer, int iCtrl, int iClientIndex, UDS_HANDOFF_SAVED *pstSaved)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+    UDS_HANDOFF_CLIENT stRecord;
+
+    // 스트림 모드 수신 큐의 메시지는 청크 체인이라 넘기지 않는다
+    pthread_mutex_lock(&pstUdsServer->mutex);
+    if ((!pstUdsServer->stConfig.iStreamMode
+         && drainHandoffQueue(&pstClient->stRecvQueue, &pstSaved->pstRecv, &pstSaved->iRecvCount) != 0)
+     || drainHandoffQueue(&pstClient->stSendQueue, &pstSaved->pstSend, &pstSaved->iSendCount) != 0
+     || drainHandoffSendMsgs(pstUdsServer, iClientIndex, &pstSaved->pstSend, &pstSaved->iSendCount) != 0) {
+        pthread_mutex_unlock(&pstUdsServer->mutex);
+        fprintf(stderr, "[Handoff] Memory allocation failed\n");
+        return -1;
+    }
+
+    memset(&stRecord, 0, sizeof(stRecord));
+    stRecord.iSlot = iClientIndex;
+    stRecord.iRecvCount = pstSaved->iRecvCount;
+    stRecord.iSendCount = pstSaved->iSendCount;
+    stRecord.iCoalesceMaxBytes = pstClient->iCoalesceMaxBytes;
+    stRecord.iCoalesceDelayUsec = pstClient->iCoalesceDelayUsec;
+    stRecord.iCoalesceLen = pstClient->iCoalesceLen;
+    if (pstUdsServer->stConfig.iStreamMode) {
+        UDS_STREAM_RX *pstRx = &pstClient->stStreamRx;
+        // 수신 중이던 프레임은 이 프로세스에서 중단 처리되고, 나머지 바이트는 새 프로세스가 버린다
+        stRecord.ullSkip = pstRx->ullSkip;
+        if (pstRx->pstMsg != NULL) {
+            stRecord.ullSkip += pstRx->pstMsg->ullLength - pstRx->pstMsg->ullReceived;
+        } else {
+            stRecord.iHeaderLen = pstRx->iHeaderLen;
+            memcpy(stRecord.uchHeader, pstRx->uchHeader, UDS_STREAM_HEADER_SIZE);
+        }
+    }
+    pthread_mutex_unlock(&pstUdsServer->mutex);
+
+    if (udsSendFd(iCtrl, &stRecord, sizeof(stRecord), pstClient->iSock) < 0
+     || (pstClient->iCoalesceLen > 0 && udsSendFd(iCtrl, pstClient->pchCoalesceBuf, pstClient->iCoalesceLen, -1) < 0)
+     || sendHandoffItems(iCtrl, pstSaved->pstRecv, pstSaved->iRecvCount) != 0
+     || sendHandoffItems(iCtrl, pstSaved->pstSend, pstSaved->iSendCount) != 0)
+        return -1;
+    return 0;
+}
+
+static int sendUdsHandoff(UDS_SERVER *pstUdsServer, int iCtrl, UDS_HANDOFF_SAVED *pstSaved)
+{
+    UDS_HANDOFF_HEADER stHeader;
+    UDS_HANDOFF_CLIENT stEnd;
+    char chAck = 0;
+
+    stHeader.uiMagic = UDS_HANDOFF_MAGIC;
+    stHeader.uiVersion = UDS_HANDOFF_VERSION;
+    stHeader.iMaxClients = pstUdsServer->iMaxClients;
+    stHeader.iClientCount = pstUdsServer->iClientCount;
+    if (udsSendFd(iCtrl, &stHeader, sizeof(stHeader), pstUdsServer->iServerSock) < 0)
+        return -1;
+
+    for (int i = 0; i < pstUdsServer->iMaxClients; ++i) {
+        if (pstUdsServer->pstClients[i].iActive && sendHandoffClient(pstUdsServer, iCtrl, i, &pstSaved[i]) != 0)
+            return -1;
+    }
+
+    memset(&stEnd, 0, sizeof(stEnd));
+    stEnd.iSlot = -1;
+    if (udsSendFd(iCtrl, &stEnd, sizeof(stEnd), -1) < 0)
+        return -1;
+    if (udsRecvFd(iCtrl, &chAck, 1, NULL) != 1 || chAck != UDS_HANDOFF_ACK)
+        return -1;
+    return 0;
+}
+
+int handoffUdsServer(UDS_SERVER *pstUdsServer, const char *pchControlPath)
+{
+    int iCtrl = createUdsClientSocket(pchControlPath);
+    if (iCtrl <= 0)
+        return -1;
+    if (checkHandoffPeer(iCtrl) != 0) {
+        close(iCtrl);
+        return -1;
+    }
+
+    UDS_HANDOFF_SAVED *pstSaved = (UDS_HANDOFF_SAVED *)calloc(pstUdsServer->iMaxClients, sizeof(UDS_HANDOFF_SAVED));
+    if (pstSaved == NULL) {
+        fprintf(stderr, "[Handoff] Memory allocation failed\n");
+        close(iCtrl);
+        return -1;
+    }
+
+    // 리스닝 소켓과 클라이언트 소켓은 후속 프로세스와 공유되므로 shutdown()하지 않고 스레드만 멈춘다.
+    // 데이터그램 소켓은 넘기지 않으므로 수신 스레드를 깨우기 위해 끊어도 된다.
+    unsigned long long ullStartUsec = getUdsMonotonicUsec();
+    blockUdsServerApi(pstUdsServer);
+    // 끊긴 소켓에서 깨어난 데이터그램 수신 스레드가 빈 결과를 큐에 넣지 않고 끝나도록 먼저 멈춤을 표시한다
+    __atomic_store_n(&pstUdsServer->iRunning, 0, __ATOMIC_SEQ_CST);
+    if (pstUdsServer->iDgramSock >= 0)
+        shutdown(pstUdsServer->iDgramSock, SHUT_RDWR);
+    haltUdsServerThreads(pstUdsServer);
+
+    int iRet = sendUdsHandoff(pstUdsServer, iCtrl, pstSaved);
+    close(iCtrl);
+
+    pthread_mutex_lock(&pstUdsServer->mutex);
+    for (int i = 0; i < pstUdsServer->iMaxClients; ++i) {
+        CLIENT *pstClient = &pstUdsServer->pstClients[i];
+        if (iRet == 0) {
+            freeHandoffItems(pstSaved[i].pstRecv, pstSaved[i].iRecvCount);
+            freeHandoffItems(pstSaved[i].pstSend, pstSaved[i].iSendCount);
+        } else if (pstClient->iActive) {
+            restoreHandoffQueue(pstUdsServer, i, UDS_QUEUE_RECV, pstSaved[i].pstRecv, pstSaved[i].iRecvCount);
+            restoreHandoffQueue(pstUdsServer, i, UDS_QUEUE_SEND, pstSaved[i].pstSend, pstSaved[i].iSendCount);
+        }
+    }
+    pthread_mutex_unlock(&pstUdsServer->mutex);
+    free(pstSaved);
+
+    if (iRet != 0) {
+        fprintf(stderr, "[Handoff] Transfer to %s failed, resuming\n", pchControlPath);
+        if (pstUdsServer->iDgramSock >= 0) {
+            udsClose(pstUdsServer->iDgramSock);
+            pstUdsServer->iDgramSock = createUdsDgramServerSocket(pstUdsServer->stConfig.pchDgramPath);
+            if (pstUdsServer->iDgramSock < 0) {
+                discardUdsDgramMsgs(pstUdsServer);
+                queueDestroy(&pstUdsServer->stDgramQueue);
+            }
+        }
+        // 다시 시작하지 못하면 서버가 정리되므로 공개 API는 계속 막아 둔다
+        if (launchUdsServerThreads(pstUdsServer) == 0)
+            __atomic_store_n(&pstUdsServer->iHandingOff, 0, __ATOMIC_SEQ_CST);
+        return -1;
+    }
+
+    printf("[Handoff] %d clients handed off to %s in %llu us\n", pstUdsServer->iClientCount, pchControlPath,
+           getUdsMonotonicUsec() - ullStartUsec);
+    destroyUdsServer(pstUdsServer);
+    return 0;
+}
+
+static int recvHandoffMessage(int iCtrl, void **ppvData)
+{
+    int iSize = 0;
+
+    *ppvData = NULL;
+    if (udsRecvFd(iCtrl, &iSize, sizeof(int), NULL) != sizeof(int) || iSize <= 0 || iSize > UDS_HANDOFF_MAX_MSG)
+        return -1;
+    *ppvData = malloc(iSize);
+    if (*ppvData == NULL || udsRecvFd(iCtrl, *ppvData, iSize, NULL) != iSize) {
+        free(*ppvData);
+        *ppvData = NULL;
+        return -1;
+    }
+    return iSize;
+}
+
+static int restoreHandoffClient(UDS_SERVER *pstUdsServer, int iCtrl, const UDS_HANDOFF_CLIENT *pstRecord, int iClientFd)
+{
+    int iSlot = pstRecord->iSlot;
+    int iValid = 0;
+    char *pchCoalesce = NULL;
+
+    pthread_mutex_lock(&pstUdsServer->mutex);
+    if (iClientFd >= 0 && iSlot < pstUdsServer->iMaxClients && !pstUdsServer->pstClients[iSlot].iActive) {
+        activateUdsClient(pstUdsServer, iSlot, iClientFd);
+        iValid = 1;
+    }
+    pthread_mutex_unlock(&pstUdsServer->mutex);
+    if (!iValid) {
+        fprintf(stderr, "[Handoff] Cannot restore client %d, dropping\n", iSlot);
+        if (iClientFd >= 0)
+            close(iClientFd);
+    }
+
+    if (pstRecord->iCoalesceLen > 0) {
+        pchCoalesce = (char *)malloc(pstRecord->iCoalesceLen);
+        if (pchCoalesce == NULL || udsRecvFd(iCtrl, pchCoalesce, pstRecord->iCoalesceLen, NULL) != pstRecord->iCoalesceLen) {
+            free(pchCoalesce);
+            return -1;
+        }
+    }
+    if (iValid && pstRecord->iCoalesceMaxBytes > 0
+     && setUdsClientCoalescing(pstUdsServer, iSlot, pstRecord->iCoalesceMaxBytes, pstRecord->iCoalesceDelayUsec) == 0
+     && pstRecord->iCoalesceLen <= pstRecord->iCoalesceMaxBytes) {
+        CLIENT *pstClient = &pstUdsServer->pstClients[iSlot];
+        memcpy(pstClient->pchCoalesceBuf, pchCoalesce, pstRecord->iCoalesceLen);
+        pstClient->iCoalesceLen = pstRecord->iCoalesceLen;
+        pstClient->ullCoalesceStartUsec = getUdsMonotonicUsec();
+    } else if (iValid && pchCoalesce != NULL) {
+        // 병합 설정을 복원하지 못하면 모인 데이터를 뒤따르는 송신 메시지보다 먼저 송신 큐에 넣는다
+        if (udsServerQueueSend(pstUdsServer, iSlot, pchCoalesce, pstRecord->iCoalesceLen) == 0)
+            pchCoalesce = NULL;
+    }
+    free(pchCoalesce);
+
+    if (iValid && pstUdsServer->stConfig.iStreamMode) {
+        UDS_STREAM_RX *pstRx = &pstUdsServer->pstClients[iSlot].stStreamRx;
+        pstRx->iHeaderLen = pstRecord->iHeaderLen;
+        memcpy(pstRx->uchHeader, pstRecord->uchHeader, UDS_STREAM_HEADER_SIZE);
+        pstRx->ullSkip = pstRecord->ullSkip;
+    }
+
+    for (int i = 0; i < pstRecord->iRecvCount + pstRecord->iSendCount; ++i) {
+        void *pvData = NULL;
+        int iSize = recvHandoffMessage(iCtrl, &pvData);
+        if (iSize < 0)
+            return -1;
+        int iDirection = i < pstRecord->iRecvCount ? UDS_QUEUE_RECV : UDS_QUEUE_SEND;
+        int iQueued = 0;
+        if (iValid && iDirection == UDS_QUEUE_SEND) {
+            // 송신 백로그는 용량 10의 송신 큐를 넘을 수 있으므로 제한 없는 MPSC 큐로 다시 넣는다
+            unsigned int uiGeneration = __atomic_load_n(&pstUdsServer->pstClients[iSlot].uiGeneration, __ATOMIC_ACQUIRE);
+            iQueued = pushUdsSendMsg(pstUdsServer, iSlot, uiGeneration, (const char *)pvData, iSize) == 0;
+            if (iQueued)
+                free(pvData);
+        } else if (iValid) {
+            CLIENT *pstClient = &pstUdsServer->pstClients[iSlot];
+            pthread_mutex_lock(&pstUdsServer->mutex);
+            if (reserveUdsMemory(pstUdsServer, iSlot, iDirection, iSize)) {
+                QUEUE *pstQueue = iDirection == UDS_QUEUE_RECV ? &pstClient->stRecvQueue : &pstClient->stSendQueue;
+                iQueued = queuePush(pstQueue, pvData, iSize) != 0;
+                if (!iQueued)
+                    releaseUdsMemory(pstUdsServer, iSlot, iDirection, iSize);
+            }
+            pthread_mutex_unlock(&pstUdsServer->mutex);
+        }
+        if (!iQueued) {
+            if (iValid)
+                fprintf(stderr, "[Handoff] Client %d: no room, dropping %d bytes\n", iSlot, iSize);
+            free(pvData);
+        }
+    }
+    return 0;
+}
+
+static int receiveUdsHandoff(UDS_SERVER *pstUdsServer, const UDS_SERVER_CONFIG *pstConfig, int iCtrl)
+{
+    UDS_HANDOFF_HEADER stHeader;
+    int iServerSock = -1;
+    char chAck = UDS_HANDOFF_ACK;
+
+    if (udsRecvFd(iCtrl, &stHeader, sizeof(stHeader), &iServerSock) != sizeof(stHeader) || iServerSock < 0
+     || stHeader.uiMagic != UDS_HANDOFF_MAGIC || stHeader.uiVersion != UDS_HANDOFF_VERSION) {
+        fprintf(stderr, "[Handoff] Invalid handoff header\n");
+        if (iServerSock >= 0)
+            close(iServerSock);
+        return -1;
+    }
+    if (prepareUdsServer(pstUdsServer, pstConfig, iServerSock) != 0) {
+        close(iServerSock);
+        return -1;
+    }
+
+    for (;;) {
+        UDS_HANDOFF_CLIENT stRecord;
+        int iClientFd = -1;
+        if (udsRecvFd(iCtrl, &stRecord, sizeof(stRecord), &iClientFd) != sizeof(stRecord)) {
+            fprintf(stderr, "[Handoff] Transfer interrupted\n");
+            destroyUdsServer(pstUdsServer);
+            return -1;
+        }
+        if (stRecord.iSlot < 0)
+            break;
+        if (restoreHandoffClient(pstUdsServer, iCtrl, &stRecord, iClientFd) != 0) {
+            fprintf(stderr, "[Handoff] Transfer interrupted\n");
+            destroyUdsServer(pstUdsServer);
+            return -1;
+        }
+    }
+
+    // 이전 프로세스는 이 응답을 받은 뒤에야 자기 쪽 소켓을 닫는다
+    if (udsSendFd(iCtrl, &chAck, 1, -1) < 0) {
+        destroyUdsServer(pstUdsServer);
+        return -1;
+    }
+    printf("[Handoff] Restored %d/%d clients\n", pstUdsServer->iClientCount, stHeader.iClientCount);
+    return launchUdsServerThreads(pstUdsServer);
+}
+
+int startUdsServerFromHandoff(UDS_SERVER *pstUdsServer, const UDS_SERVER_CONFIG *pstConfig,
+                              const char *pchControlPath, int iTimeoutMsec)
+{
+    int iListenSock = createUdsServerSocket(pchControlPath, 1);
+    struct pollfd stPollFd;
+
+    stPollFd.fd = iListenSock;
+    stPollFd.events = POLLIN;
+    int iReady = poll(&stPollFd, 1, iTimeoutMsec);
+    int iCtrl = iReady > 0 ? acceptUdsClient(iListenSock) : -1;
+    udsClose(iListenSock);
+    unlink(pchControlPath);
+    if (iReady == 0)
+        return UDS_TIME_OUT;
+    if (iCtrl < 0)
+        return -1;
+    if (checkHandoffPeer(iCtrl) != 0) {
+        udsClose(iCtrl);
+        return -1;
+    }
+
+    int iRet = receiveUdsHandoff(pstUdsServer, pstConfig, iCtrl);
+    udsClose(iCtrl);
+    return iRet;
+}
@@ -0,0 +1,331 @@
+/**
+ * @file memory-budget.c
+ * @brief 서버 전체 메모리 예산 집계 및 과부하 처리
+ *
+ * 이 파일은 모든 클라이언트의 송수신 큐에 쌓인 바이트 수를 집계하고,
+ * 설정된 예산을 넘을 때 과부하 정책(새 메시지 버림, 오래된 메시지 버림,
+ * 최다 사용 클라이언트 연결 종료, 읽기 중단)을 적용하는 루틴을 정의합니다.
+ */
+
+#include "uds-server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+
+static unsigned long long* getUdsQueuedCounter(CLIENT *pstClient, int iDirection)
+{
+    return iDirection == UDS_QUEUE_SEND ? &pstClient->ullSendQueuedBytes : &pstClient->ullRecvQueuedBytes;
+}
+
+static unsigned long long getUdsTotalBytes(UDS_SERVER *pstUdsServer)
+{
+    return __atomic_load_n(&pstUdsServer->stStats.ullQueuedBytes, __ATOMIC_RELAXED)
+         + __atomic_load_n(&pstUdsServer->stChunkPool.ullInUseBytes, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 최대 집계 바이트 수 갱신
+ *
+ * udsServerSend()가 뮤텍스 없이 같은 통계를 갱신하므로 모든 쓰기를 원자적으로 한다.
+ */
+static void updateUdsPeakBytes(UDS_SERVER *pstUdsServer, unsigned long long ullTotal)
+{
+    unsigned long long ullPeak = __atomic_load_n(&pstUdsServer->stStats.ullPeakQueuedBytes, __ATOMIC_RELAXED);
+    while (ullTotal > ullPeak
+        && !__atomic_compare_exchange_n(&pstUdsServer->stStats.ullPeakQueuedBytes, &ullPeak, ullTotal,
+                                        1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+static void countUdsDropped(UDS_SERVER *pstUdsServer, unsigned long long *pullCounter, int iSize)
+{
+    __atomic_add_fetch(pullCounter, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&pstUdsServer->stStats.ullDroppedBytes, iSize, __ATOMIC_RELAXED);
+}
+
+static void freeUdsQueuedItem(UDS_SERVER *pstUdsServer, int iDirection, void *pvData)
+{
+    if (iDirection == UDS_QUEUE_RECV && pstUdsServer->stConfig.iStreamMode)
+        udsStreamMsgRelease((UDS_STREAM_MSG *)pvData);
+    else
+        free(pvData);
+}
+
+/**
+ * @brief 클라이언트 큐에서 가장 오래된 메시지 하나를 버림
+ *
+ * @return 버렸으면 1, 큐가 비어 있으면 0
+ */
+static int dropUdsOldest(UDS_SERVER *pstUdsServer, int iClientIndex, int iDirection)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+    QUEUE *pstQueue = iDirection == UDS_QUEUE_SEND ? &pstClient->stSendQueue : &pstClient->stRecvQueue;
+    void *pvData = NULL;
+
+    int iSize = queuePop(pstQueue, &pvData);
+    if (iSize > 0 && pvData != NULL) {
+        releaseUdsMemory(pstUdsServer, iClientIndex, iDirection, iSize);
+        freeUdsQueuedItem(pstUdsServer, iDirection, pvData);
+    } else if (iDirection == UDS_QUEUE_SEND && (pvData = popUdsSendMsg(pstUdsServer, iClientIndex)) != NULL) {
+        // 송신 큐가 비었으면 udsServerSend()로 쌓인 메시지를 버린다 (뮤텍스를 잡고 있으므로 소비자 자격이 있다)
+        iSize = ((UDS_SEND_MSG *)pvData)->iLength;
+        free(pvData);
+    } else {
+        return 0;
+    }
+    countUdsDropped(pstUdsServer, &pstUdsServer->stStats.ullDroppedOldest, iSize);
+    return 1;
+}
+
+static unsigned long long getUdsClientSendBytes(CLIENT *pstClient)
+{
+    return pstClient->ullSendQueuedBytes + __atomic_load_n(&pstClient->ullSendMpscBytes, __ATOMIC_RELAXED);
+}
+
+static int findUdsWorstClient(UDS_SERVER *pstUdsServer)
+{
+    int iWorst = -1;
+    unsigned long long ullWorstBytes = 0;
+
+    for (int i = 0; i < pstUdsServer->iMaxClients; ++i) {
+        CLIENT *pstClient = &pstUdsServer->pstClients[i];
+        unsigned long long ullBytes = pstClient->ullRecvQueuedBytes + getUdsClientSendBytes(pstClient)
+                                    + __atomic_load_n(&pstClient->ullChunkBytes, __ATOMIC_RELAXED);
+        if (pstClient->iActive && !pstClient->iEvicted && ullBytes > ullWorstBytes) {
+            iWorst = i;
+            ullWorstBytes = ullBytes;
+        }
+    }
+    return iWorst;
+}
+
+#define UDS_EVICT_NONE      0   ///< 더 이상 확보할 수 없음
+#define UDS_EVICT_FREED     1   ///< 메시지를 버려 바이트를 돌려받음
+#define UDS_EVICT_PENDING   2   ///< 연결을 끊었으나 청크 바이트는 수신 스레드가 해제할 때 돌아옴
+
+/**
+ * @brief 과부하 정책에 따라 공간을 한 번 확보
+ *
+ * @return UDS_EVICT_NONE, UDS_EVICT_FREED, UDS_EVICT_PENDING 중 하나
+ */
+static int evictUdsMemory(UDS_SERVER *pstUdsServer, int iClientIndex, int iDirection)
+{
+    switch (pstUdsServer->stConfig.iOverloadPolicy) {
+    case UDS_OVERLOAD_DROP_OLDEST: {
+        if (iDirection != UDS_QUEUE_CHUNK && dropUdsOldest(pstUdsServer, iClientIndex, iDirection))
+            return UDS_EVICT_FREED;
+        int iWorst = findUdsWorstClient(pstUdsServer);
+        if (iWorst < 0)
+            return UDS_EVICT_NONE;
+        CLIENT *pstWorst = &pstUdsServer->pstClients[iWorst];
+        int iWorstDirection = getUdsClientSendBytes(pstWorst) > pstWorst->ullRecvQueuedBytes ? UDS_QUEUE_SEND : UDS_QUEUE_RECV;
+        return dropUdsOldest(pstUdsServer, iWorst, iWorstDirection) ? UDS_EVICT_FREED : UDS_EVICT_NONE;
+    }
+    case UDS_OVERLOAD_DISCONNECT_WORST: {
+        int iWorst = findUdsWorstClient(pstUdsServer);
+        if (iWorst < 0)
+            return UDS_EVICT_NONE;
+        // 슬롯 해제는 담당 수신 스레드가 하도록 소켓만 끊고, 쌓인 메시지는 즉시 비운다
+        CLIENT *pstWorst = &pstUdsServer->pstClients[iWorst];
+        // 청크는 수신 스레드가 연결을 해제할 때 돌아오므로, 그때까지 다시 고르지 않도록 표시한다
+        fprintf(stderr, "[Overload] Disconnect client %d (%llu bytes queued, %llu bytes in chunks)\n", iWorst,
+                pstWorst->ullRecvQueuedBytes + getUdsClientSendBytes(pstWorst),
+                __atomic_load_n(&pstWorst->ullChunkBytes, __ATOMIC_RELAXED));
+        pstWorst->iEvicted = 1;
+        shutdown(pstWorst->iSock, SHUT_RDWR);
+        while (dropUdsOldest(pstUdsServer, iWorst, UDS_QUEUE_RECV))
+            ;
+        while (dropUdsOldest(pstUdsServer, iWorst, UDS_QUEUE_SEND))
+            ;
+        __atomic_add_fetch(&pstUdsServer->stStats.ullDisconnects, 1, __ATOMIC_RELAXED);
+        return iWorst != iClientIndex ? UDS_EVICT_PENDING : UDS_EVICT_NONE;
+    }
+    default:
+        return UDS_EVICT_NONE;
+    }
+}
+
+/**
+ * @brief 예산 안에서 iMinSize 이상 iMaxSize 이하 바이트를 iDirection의 서버 집계에 더함
+ *
+ * 확인과 집계를 한 번의 CAS로 하므로 뮤텍스 없이 동시에 집계해도 예산을 넘지 않는다.
+ * 청크는 청크 풀의 사용량에, 나머지는 큐 집계에 더한다.
+ *
+ * @return 집계한 바이트 수, 예산이 모자라면 0
+ */
+static int chargeUdsBudgetRange(UDS_SERVER *pstUdsServer, int iDirection, int iMinSize, int iMaxSize)
+{
+    unsigned long long ullBudget = pstUdsServer->stConfig.ullMemoryBudget;
+    unsigned long long *pullCounter = &pstUdsServer->stStats.ullQueuedBytes;
+    unsigned long long *pullOther = &pstUdsServer->stChunkPool.ullInUseBytes;
+    if (iDirection == UDS_QUEUE_CHUNK) {
+        pullCounter = &pstUdsServer->stChunkPool.ullInUseBytes;
+        pullOther = &pstUdsServer->stStats.ullQueuedBytes;
+    }
+    unsigned long long ullCurrent = __atomic_load_n(pullCounter, __ATOMIC_RELAXED);
+    unsigned long long ullTotal;
+    int iSize;
+
+    do {
+        ullTotal = ullCurrent + __atomic_load_n(pullOther, __ATOMIC_RELAXED);
+        iSize = iMaxSize;
+        if (ullBudget > 0 && ullTotal + iSize > ullBudget)
+            iSize = ullTotal >= ullBudget ? 0 : (int)(ullBudget - ullTotal);
+        if (iSize < iMinSize || iSize <= 0)
+            return 0;
+    } while (!__atomic_compare_exchange_n(pullCounter, &ullCurrent, ullCurrent + iSize,
+                                          1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    updateUdsPeakBytes(pstUdsServer, ullTotal + iSize);
+    return iSize;
+}
+
+int reserveUdsMemory(UDS_SERVER *pstUdsServer, int iClientIndex, int iDirection, int iSize)
+{
+    int iDisconnected = 0;
+
+    while (!chargeUdsBudgetRange(pstUdsServer, iDirection, iSize, iSize)) {
+        // 연결을 끊어도 청크 바이트는 수신 스레드가 해제할 때까지 남으므로,
+        // 한 번 끊은 뒤에는 더 끊지 않고 버린 큐 바이트만으로 다시 한 번 시도한다
+        int iEvict = iDisconnected ? UDS_EVICT_NONE : evictUdsMemory(pstUdsServer, iClientIndex, iDirection);
+        if (iEvict == UDS_EVICT_NONE) {
+            if (iDirection != UDS_QUEUE_CHUNK)
+                countUdsDropped(pstUdsServer, &pstUdsServer->stStats.ullDroppedNewest, iSize);
+            return 0;
+        }
+        if (iEvict == UDS_EVICT_PENDING)
+            iDisconnected = 1;
+    }
+
+    if (iDirection != UDS_QUEUE_CHUNK)
+        *getUdsQueuedCounter(&pstUdsServer->pstClients[iClientIndex], iDirection) += iSize;
+    return 1;
+}
+
+int reserveUdsReadRoom(UDS_SERVER *pstUdsServer, int iClientIndex, int iMaxSize)
+{
+    int iSize = chargeUdsBudgetRange(pstUdsServer, UDS_QUEUE_RECV, 1, iMaxSize);
+
+    pstUdsServer->pstClients[iClientIndex].ullRecvQueuedBytes += iSize;
+    return iSize;
+}
+
+void releaseUdsMemory(UDS_SERVER *pstUdsServer, int iClientIndex, int iDirection, int iSize)
+{
+    unsigned long long *pullCounter = getUdsQueuedCounter(&pstUdsServer->pstClients[iClientIndex], iDirection);
+    unsigned long long ullRelease = (unsigned long long)iSize < *pullCounter ? (unsigned long long)iSize : *pullCounter;
+
+    *pullCounter -= ullRelease;
+    __atomic_sub_fetch(&pstUdsServer->stStats.ullQueuedBytes, ullRelease, __ATOMIC_RELAXED);
+    resumeUdsReads(pstUdsServer);
+}
+
+/**
+ * @brief 서버 뮤텍스 없이 예산에 iSize 바이트를 집계 (넘치면 새 메시지 버림으로 집계)
+ */
+static int chargeUdsBudget(UDS_SERVER *pstUdsServer, int iSize)
+{
+    if (chargeUdsBudgetRange(pstUdsServer, UDS_QUEUE_RECV, iSize, iSize))
+        return 1;
+    countUdsDropped(pstUdsServer, &pstUdsServer->stStats.ullDroppedNewest, iSize);
+    return 0;
+}
+
+int reserveUdsSharedMemory(UDS_SERVER *pstUdsServer, int iClientIndex, int iSize)
+{
+    // 예산이 없으면 서버 전체 집계를 건너뛰어 생산자끼리 같은 캐시 라인을 두고 다투지 않게 한다
+    // (통계는 조회할 때 클라이언트별 집계를 합산)
+    if (pstUdsServer->stConfig.ullMemoryBudget > 0 && !chargeUdsBudget(pstUdsServer, iSize))
+        return 0;
+    // 과부하 정책이 느린 클라이언트를 찾을 수 있도록 클라이언트별로도 집계한다
+    __atomic_add_fetch(&pstUdsServer->pstClients[iClientIndex].ullSendMpscBytes, iSize, __ATOMIC_RELAXED);
+    return 1;
+}
+
+void releaseUdsSharedMemory(UDS_SERVER *pstUdsServer, int iClientIndex, int iSize)
+{
+    __atomic_sub_fetch(&pstUdsServer->pstClients[iClientIndex].ullSendMpscBytes, iSize, __ATOMIC_RELAXED);
+    if (pstUdsServer->stConfig.ullMemoryBudget > 0) {
+        __atomic_sub_fetch(&pstUdsServer->stStats.ullQueuedBytes, iSize, __ATOMIC_RELAXED);
+        resumeUdsReads(pstUdsServer);
+    }
+}
+
+int reserveUdsDgramMemory(UDS_SERVER *pstUdsServer, int iSize)
+{
+    // 데이터그램은 연결이 없어 다른 클라이언트의 메시지를 밀어낼 수 없으므로 새 것을 버린다
+    return chargeUdsBudget(pstUdsServer, iSize);
+}
+
+void releaseUdsDgramMemory(UDS_SERVER *pstUdsServer, int iSize)
+{
+    __atomic_sub_fetch(&pstUdsServer->stStats.ullQueuedBytes, iSize, __ATOMIC_RELAXED);
+    resumeUdsReads(pstUdsServer);
+}
+
+int isUdsMemoryShort(UDS_SERVER *pstUdsServer, unsigned long long ullNeedBytes)
+{
+    unsigned long long ullBudget = pstUdsServer->stConfig.ullMemoryBudget;
+
+    return ullBudget > 0 && getUdsTotalBytes(pstUdsServer) + ullNeedBytes > ullBudget;
+}
+
+int pauseUdsReads(UDS_SERVER *pstUdsServer, unsigned long long ullNeedBytes)
+{
+    // 표시를 먼저 남긴 뒤 다시 확인해야, 그 사이에 해제한 쪽이 깨우지 않고 지나가는 일이 없다
+    __atomic_store_n(&pstUdsServer->iReadPaused, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return isUdsMemoryShort(pstUdsServer, ullNeedBytes);
+}
+
+void resumeUdsReads(UDS_SERVER *pstUdsServer)
+{
+    if (pstUdsServer->stConfig.ullMemoryBudget == 0)
+        return;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pstUdsServer->iReadPaused, __ATOMIC_RELAXED)
+     && __atomic_exchange_n(&pstUdsServer->iReadPaused, 0, __ATOMIC_ACQ_REL)) {
+        for (int i = 0; i < pstUdsServer->stConfig.iRecvThreadCount; ++i)
+            wakeUdsRecvThread(pstUdsServer, i);
+    }
+}
+
+int udsServerQueueSend(UDS_SERVER *pstUdsServer, int iClientIndex, void *pvData, int iSize)
+{
+    int iRet = -1;
+
+    if (iClientIndex < 0 || iClientIndex >= pstUdsServer->iMaxClients || iSize <= 0)
+        return -1;
+    if (enterUdsServerApi(pstUdsServer) != 0)
+        return UDS_HANDING_OFF;
+
+    pthread_mutex_lock(&pstUdsServer->mutex);
+    if (pstUdsServer->pstClients[iClientIndex].iActive
+     && reserveUdsMemory(pstUdsServer, iClientIndex, UDS_QUEUE_SEND, iSize)) {
+        if (queuePush(&pstUdsServer->pstClients[iClientIndex].stSendQueue, pvData, iSize)) {
+            signalUdsSend(pstUdsServer, iClientIndex);
+            iRet = 0;
+        } else
+            releaseUdsMemory(pstUdsServer, iClientIndex, UDS_QUEUE_SEND, iSize);
+    }
+    pthread_mutex_unlock(&pstUdsServer->mutex);
+    leaveUdsServerApi(pstUdsServer);
+    return iRet;
+}
+
+void getUdsServerStats(UDS_SERVER *pstUdsServer, UDS_SERVER_STATS *pstStats)
+{
+    const unsigned long long *pullSrc = (const unsigned long long *)&pstUdsServer->stStats;
+    unsigned long long *pullDst = (unsigned long long *)pstStats;
+
+    // 일부 항목은 뮤텍스 밖에서 원자적으로 갱신되므로 항목별로 원자적으로 읽는다
+    pthread_mutex_lock(&pstUdsServer->mutex);
+    for (size_t i = 0; i < sizeof(UDS_SERVER_STATS) / sizeof(unsigned long long); ++i)
+        pullDst[i] = __atomic_load_n(&pullSrc[i], __ATOMIC_RELAXED);
+    pstStats->ullQueuedBytes = getUdsTotalBytes(pstUdsServer);
+    if (pstUdsServer->stConfig.ullMemoryBudget == 0) {
+        for (int i = 0; i < pstUdsServer->iMaxClients; ++i)
+            pstStats->ullQueuedBytes += __atomic_load_n(&pstUdsServer->pstClients[i].ullSendMpscBytes, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&pstUdsServer->mutex);
+}
@@ -0,0 +1,59 @@
+/**
+ * @file mpsc.c
+ * @brief 잠금 없는 다중 생산자 단일 소비자 큐
+ *
+ * 이 파일은 송신 API가 서버 뮤텍스 없이 메시지를 넣을 때 쓰는
+ * 침입형 Vyukov MPSC 큐의 넣기/꺼내기 루틴을 정의합니다.
+ */
+
+#include "uds-mpsc.h"
+
+void initUdsMpscQueue(UDS_MPSC_QUEUE *pstQueue)
+{
+    pstQueue->stStub.pstNext = NULL;
+    pstQueue->pstHead = &pstQueue->stStub;
+    pstQueue->pstTail = &pstQueue->stStub;
+}
+
+void pushUdsMpscQueue(UDS_MPSC_QUEUE *pstQueue, UDS_MPSC_NODE *pstNode)
+{
+    __atomic_store_n(&pstNode->pstNext, NULL, __ATOMIC_RELAXED);
+    UDS_MPSC_NODE *pstPrev = __atomic_exchange_n(&pstQueue->pstHead, pstNode, __ATOMIC_ACQ_REL);
+    // 여기서 멈춘 생산자가 있으면 소비자는 pstPrev 뒤를 아직 볼 수 없다
+    __atomic_store_n(&pstPrev->pstNext, pstNode, __ATOMIC_RELEASE);
+}
+
+UDS_MPSC_NODE* popUdsMpscQueue(UDS_MPSC_QUEUE *pstQueue)
+{
+    UDS_MPSC_NODE *pstTail = pstQueue->pstTail;
+    UDS_MPSC_NODE *pstNext = __atomic_load_n(&pstTail->pstNext, __ATOMIC_ACQUIRE);
+
+    if (pstTail == &pstQueue->stStub) {
+        if (pstNext == NULL)
+            return NULL;
+        pstQueue->pstTail = pstNext;
+        pstTail = pstNext;
+        pstNext = __atomic_load_n(&pstNext->pstNext, __ATOMIC_ACQUIRE);
+    }
+    if (pstNext != NULL) {
+        pstQueue->pstTail = pstNext;
+        return pstTail;
+    }
+
+    // 마지막 노드는 뒤에 스텁을 붙여야 꺼낼 수 있다
+    if (pstTail != __atomic_load_n(&pstQueue->pstHead, __ATOMIC_ACQUIRE))
+        return NULL;
+    pushUdsMpscQueue(pstQueue, &pstQueue->stStub);
+    pstNext = __atomic_load_n(&pstTail->pstNext, __ATOMIC_ACQUIRE);
+    if (pstNext != NULL) {
+        pstQueue->pstTail = pstNext;
+        return pstTail;
+    }
+    return NULL;
+}
+
+int isUdsMpscQueueEmpty(UDS_MPSC_QUEUE *pstQueue)
+{
+    return pstQueue->pstTail == &pstQueue->stStub
+        && __atomic_load_n(&pstQueue->stStub.pstNext, __ATOMIC_ACQUIRE) == NULL;
+}
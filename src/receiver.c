@@ -15,65 +15,174 @@
 #include <unistd.h>
 #include <stdlib.h>
 
+/**
+ * @brief 수신 스레드가 담당하는 활성 클라이언트로 poll 목록을 구성
+ *
+ * 0번 항목은 항상 스레드의 wake 파이프입니다.
+ * 읽기를 멈춘 동안에는 클라이언트의 POLLIN을 빼서 연결 끊김(POLLHUP/POLLERR)만 감지합니다.
+ *
+ * @return poll 목록 항목 수
+ */
+static int buildPollList(UDS_SERVER_THREAD *pstThread, struct pollfd *pstPollFds, int *piPollSlots, int iReadPaused)
+{
+    UDS_SERVER* pstUdsServer = pstThread->pstServer;
+    int iPollCount = 0;
+
+    pstPollFds[iPollCount].fd = pstThread->aiWakeFd[0];
+    pstPollFds[iPollCount].events = POLLIN;
+    piPollSlots[iPollCount] = -1;
+    iPollCount++;
+    pthread_mutex_lock(&pstUdsServer->mutex);
+    for (int iClientIndex = pstThread->iIndex; iClientIndex < pstUdsServer->iMaxClients; iClientIndex += pstThread->iCount) {
+        if (pstUdsServer->pstClients[iClientIndex].iActive) {                
+            pstPollFds[iPollCount].fd = pstUdsServer->pstClients[iClientIndex].iSock;
+            pstPollFds[iPollCount].events = iReadPaused ? 0 : POLLIN;
+            piPollSlots[iPollCount] = iClientIndex;
+            iPollCount++;
+        }            
+    }
+    pthread_mutex_unlock(&pstUdsServer->mutex);
+    return iPollCount;
+}
+
+static void releasePolledClient(UDS_SERVER *pstUdsServer, int iClientIndex, int iClientFd)
+{
+    pthread_mutex_lock(&pstUdsServer->mutex);
+    if (pstUdsServer->pstClients[iClientIndex].iActive && pstUdsServer->pstClients[iClientIndex].iSock == iClientFd)
+        releaseUdsClient(pstUdsServer, iClientIndex);
+    pthread_mutex_unlock(&pstUdsServer->mutex);
+}
+
 void* recvThread(void* arg) 
 {
-    UDS_SERVER* pstUdsServer = (UDS_SERVER *)arg;
+    UDS_SERVER_THREAD* pstThread = (UDS_SERVER_THREAD *)arg;
+    UDS_SERVER* pstUdsServer = pstThread->pstServer;
     int iMaxClients = pstUdsServer->iMaxClients;    
-    struct pollfd stPollFds[iMaxClients];
+    struct pollfd stPollFds[iMaxClients + 1];
+    int iPollSlots[iMaxClients + 1];
+    int iPollCount = 0;
+    int iRebuild = 1;
+    int iBusyPollUsec = pstUdsServer->stConfig.iBusyPollUsec;
+    int iReadPaused = 0;
+    unsigned long long ullPauseNeedBytes = 0;
+    unsigned long long ullLastActiveUsec = getUdsMonotonicUsec();
 
-    while (1) {
-        int iPollCount = 0;
-        pthread_mutex_lock(&pstUdsServer->mutex);
-        for (int iPollFdIndex = 0; iPollFdIndex < iMaxClients; iPollFdIndex++) {
-            if (pstUdsServer->pstClients[iPollFdIndex].iActive) {                
-                stPollFds[iPollCount].fd = pstUdsServer->pstClients[iPollFdIndex].iSock;
-                stPollFds[iPollCount].events = POLLIN;
-                iPollCount++;
-            }            
+    while (pstUdsServer->iRunning) {
+        if (iReadPaused && !isUdsMemoryShort(pstUdsServer, ullPauseNeedBytes)) {
+            iReadPaused = 0;
+            iRebuild = 1;
+        }
+        // 바쁜 대기 구간에서는 poll(0)을 반복하고, 그 외에는 최대 500ms 블로킹한다.
+        // 읽기를 멈춘 동안에는 예산이 풀릴 때 wake 파이프로 깨어난다.
+        int iSpinning = !iReadPaused && iBusyPollUsec > 0
+                     && getUdsMonotonicUsec() - ullLastActiveUsec < (unsigned long long)iBusyPollUsec;
+        if (iRebuild || !iSpinning) {
+            iPollCount = buildPollList(pstThread, stPollFds, iPollSlots, iReadPaused);
+            iRebuild = 0;
         }
-        pthread_mutex_unlock(&pstUdsServer->mutex);
 
-        int iReady = poll(stPollFds, iPollCount, 500);
-        if (iReady <= 0)
+        int iReady = poll(stPollFds, iPollCount, iSpinning ? 0 : 500);
+        if (iReady <= 0) {
+            if (iSpinning)
+                udsCpuRelax();
             continue;
+        }
+        ullLastActiveUsec = getUdsMonotonicUsec();
+        if (stPollFds[0].revents & POLLIN) {
+            // 새 클라이언트 등록 또는 종료 요청: 파이프를 비우고 poll 목록을 다시 만든다
+            char chDrain[64];
+            while (read(pstThread->aiWakeFd[0], chDrain, sizeof(chDrain)) > 0)
+                ;
+            iRebuild = 1;
+        }
 
-        for (int iPollFdIndex = 0; iPollFdIndex < iPollCount; iPollFdIndex++) {
-            if (stPollFds[iPollFdIndex].revents & POLLIN) {
+        for (int iPollFdIndex = 1; iPollFdIndex < iPollCount; iPollFdIndex++) {
+            short sRevents = stPollFds[iPollFdIndex].revents;
+            if (sRevents & (POLLIN | POLLHUP | POLLERR)) {
                 int iClientFd = stPollFds[iPollFdIndex].fd;
+                int iClientIndex = iPollSlots[iPollFdIndex];
                 char chBuffer[1024];
-                int iRecvSize = udsRecvMsg(iClientFd, chBuffer, sizeof(chBuffer) - 1);
-                if (iRecvSize <= 0) {                    
-                    close(iClientFd);
+                int iRecvSize;
+                int iReserved = 0;
+                if (iReadPaused) {
+                    // 끊긴 연결은 멈춘 동안에도 바로 해제하여 잡고 있던 바이트를 돌려준다
+                    if (sRevents & (POLLHUP | POLLERR)) {
+                        releasePolledClient(pstUdsServer, iClientIndex, iClientFd);
+                        iRebuild = 1;
+                    }
+                    continue;
+                }
+                if (pstUdsServer->stConfig.iStreamMode) {
+                    iRecvSize = recvUdsStream(pstUdsServer, iClientIndex);
+                    if (iRecvSize > 0 && pstUdsServer->stConfig.iIdleTimeoutMsec > 0)
+                        __atomic_store_n(&pstUdsServer->pstClients[iClientIndex].ullLastRecvUsec, getUdsMonotonicUsec(), __ATOMIC_RELAXED);
+                    if (iRecvSize == UDS_STREAM_PAUSED) {
+                        // 청크를 확보하지 못했으면 예산이 풀릴 때까지 읽기를 멈춘다
+                        if (pauseUdsReads(pstUdsServer, UDS_STREAM_CHUNK_SIZE)) {
+                            __atomic_add_fetch(&pstUdsServer->stStats.ullPausedReads, 1, __ATOMIC_RELAXED);
+                            iReadPaused = 1;
+                            ullPauseNeedBytes = UDS_STREAM_CHUNK_SIZE;
+                            iRebuild = 1;
+                        }
+                        continue;
+                    }
+                    if (iRecvSize > 0)
+                        continue;
+                } else if (pstUdsServer->stConfig.iOverloadPolicy == UDS_OVERLOAD_PAUSE_READS) {
+                    // 남은 예산만큼만 읽어야 읽은 데이터를 버리지 않고 나머지를 커널 버퍼에 남겨 송신 측에 배압을 건다
                     pthread_mutex_lock(&pstUdsServer->mutex);
-                    for (int iClientFdIndex = 0; iClientFdIndex < pstUdsServer->iMaxClients; iClientFdIndex++) {
-                        if (pstUdsServer->pstClients[iClientFdIndex].iSock == iClientFd) {
-                            pstUdsServer->pstClients[iClientFdIndex].iActive = 0;
-                            queueDestroy(&(pstUdsServer->pstClients[iClientFdIndex].stSendQueue));
-                            queueDestroy(&(pstUdsServer->pstClients[iClientFdIndex].stRecvQueue));
-                            pstUdsServer->pstClients[iClientFdIndex].iSock = -1;
-                            pstUdsServer->iClientCount--;
-                            break;
-                        }                        
+                    iReserved = reserveUdsReadRoom(pstUdsServer, iClientIndex, sizeof(chBuffer) - 1);
+                    pthread_mutex_unlock(&pstUdsServer->mutex);
+                    if (iReserved == 0) {
+                        if (sRevents & (POLLHUP | POLLERR)) {
+                            releasePolledClient(pstUdsServer, iClientIndex, iClientFd);
+                            iRebuild = 1;
+                        } else if (pauseUdsReads(pstUdsServer, 1)) {
+                            __atomic_add_fetch(&pstUdsServer->stStats.ullPausedReads, 1, __ATOMIC_RELAXED);
+                            iReadPaused = 1;
+                            ullPauseNeedBytes = 1;
+                            iRebuild = 1;
+                        }
+                        continue;
                     }
+                    iRecvSize = udsRecvMsg(iClientFd, chBuffer, iReserved);
+                } else {
+                    iRecvSize = udsRecvMsg(iClientFd, chBuffer, sizeof(chBuffer) - 1);
+                }
+                if (iRecvSize <= 0) {                    
+                    pthread_mutex_lock(&pstUdsServer->mutex);
+                    if (iReserved > 0)
+                        releaseUdsMemory(pstUdsServer, iClientIndex, UDS_QUEUE_RECV, iReserved);
                     pthread_mutex_unlock(&pstUdsServer->mutex);
+                    releasePolledClient(pstUdsServer, iClientIndex, iClientFd);
+                    iRebuild = 1;
                 } else {                    
                     chBuffer[iRecvSize] = '\0';
+                    captureUdsRecord(&pstUdsServer->stCapture, UDS_CAPTURE_DATA, iClientIndex, chBuffer, iRecvSize);
+                    if (pstUdsServer->stConfig.iIdleTimeoutMsec > 0)
+                        __atomic_store_n(&pstUdsServer->pstClients[iClientIndex].ullLastRecvUsec, getUdsMonotonicUsec(), __ATOMIC_RELAXED);
                     void* pvData = malloc(iRecvSize);
-                    if (pvData == NULL) {
+                    if (pvData == NULL)
                         fprintf(stderr, "Memory allocation failed\n");
-                    } else {
+                    else
                         memcpy(pvData, chBuffer, iRecvSize);
-                        pthread_mutex_lock(&pstUdsServer->mutex);                    
-                        for (int iClientFdIndex = 0; iClientFdIndex < pstUdsServer->iMaxClients; iClientFdIndex++) {
-                            if (pstUdsServer->pstClients[iClientFdIndex].iSock == iClientFd) {
-                                if(queuePush(&(pstUdsServer->pstClients[iClientFdIndex].stRecvQueue), pvData, iRecvSize) == 0){
-                                    fprintf(stderr,"### FAIL %s():%d Msg:%s ###\n", __func__,__LINE__, chBuffer);
-                                    break;
-                                }
-                            }
+                    pthread_mutex_lock(&pstUdsServer->mutex);                    
+                    // 미리 확보한 예산 중 쓰지 않은 몫을 돌려준다
+                    int iUsed = pvData != NULL ? iRecvSize : 0;
+                    if (iReserved > iUsed)
+                        releaseUdsMemory(pstUdsServer, iClientIndex, UDS_QUEUE_RECV, iReserved - iUsed);
+                    if (pvData != NULL) {
+                        if (iReserved == 0 && !reserveUdsMemory(pstUdsServer, iClientIndex, UDS_QUEUE_RECV, iRecvSize)) {
+                            free(pvData);
+                        } else if (queuePush(&(pstUdsServer->pstClients[iClientIndex].stRecvQueue), pvData, iRecvSize) == 0){
+                            fprintf(stderr,"### FAIL %s():%d Msg:%s ###\n", __func__,__LINE__, chBuffer);
+                            releaseUdsMemory(pstUdsServer, iClientIndex, UDS_QUEUE_RECV, iRecvSize);
+                            free(pvData);
+                        } else {
+                            signalUdsRecv(pstUdsServer, iClientIndex);
                         }
-                        pthread_mutex_unlock(&pstUdsServer->mutex);
-                    }                    
+                    }
+                    pthread_mutex_unlock(&pstUdsServer->mutex);
                 }
             }
         }
@@ -0,0 +1,100 @@
+/**
+ * @file send-queue.c
+ * @brief 다중 생산자 송신 API
+ *
+ * 이 파일은 여러 애플리케이션 스레드가 서버 뮤텍스 없이 클라이언트별
+ * MPSC 큐에 메시지를 넣는 송신 API와, 세대 번호가 붙은 클라이언트 핸들,
+ * 송신 스레드가 큐에서 메시지를 꺼내는 루틴을 정의합니다.
+ */
+
+#include "uds-server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UDS_HANDLE_SLOT_MASK    0xFFFFFFFFULL
+
+UDS_CLIENT_HANDLE getUdsClientHandle(UDS_SERVER *pstUdsServer, int iClientIndex)
+{
+    if (iClientIndex < 0 || iClientIndex >= pstUdsServer->iMaxClients)
+        return UDS_INVALID_CLIENT_HANDLE;
+    if (enterUdsServerApi(pstUdsServer) != 0)
+        return UDS_INVALID_CLIENT_HANDLE;
+
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+    unsigned int uiGeneration = __atomic_load_n(&pstClient->uiGeneration, __ATOMIC_ACQUIRE);
+    int iActive = __atomic_load_n(&pstClient->iActive, __ATOMIC_ACQUIRE);
+    leaveUdsServerApi(pstUdsServer);
+    if (!iActive)
+        return UDS_INVALID_CLIENT_HANDLE;
+    return ((UDS_CLIENT_HANDLE)uiGeneration << 32) | (unsigned int)iClientIndex;
+}
+
+int udsServerSend(UDS_SERVER *pstUdsServer, UDS_CLIENT_HANDLE ullHandle, const char *pchData, int iSize)
+{
+    int iClientIndex = (int)(ullHandle & UDS_HANDLE_SLOT_MASK);
+    unsigned int uiGeneration = (unsigned int)(ullHandle >> 32);
+
+    if (uiGeneration == 0 || iClientIndex < 0 || iClientIndex >= pstUdsServer->iMaxClients || iSize <= 0)
+        return -1;
+    if (enterUdsServerApi(pstUdsServer) != 0)
+        return UDS_HANDING_OFF;
+
+    // 여기서 확인한 뒤 슬롯이 재사용되어도 송신 스레드가 세대를 다시 확인해 버린다
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+    int iRet = 0;
+    if (__atomic_load_n(&pstClient->uiGeneration, __ATOMIC_ACQUIRE) != uiGeneration
+     || !__atomic_load_n(&pstClient->iActive, __ATOMIC_ACQUIRE)) {
+        __atomic_add_fetch(&pstUdsServer->stStats.ullStaleSends, 1, __ATOMIC_RELAXED);
+        iRet = UDS_STALE_CLIENT;
+    } else {
+        iRet = pushUdsSendMsg(pstUdsServer, iClientIndex, uiGeneration, pchData, iSize);
+    }
+    leaveUdsServerApi(pstUdsServer);
+    return iRet;
+}
+
+int pushUdsSendMsg(UDS_SERVER *pstUdsServer, int iClientIndex, unsigned int uiGeneration, const char *pchData, int iSize)
+{
+    if (!reserveUdsSharedMemory(pstUdsServer, iClientIndex, iSize))
+        return -1;
+
+    UDS_SEND_MSG *pstMsg = (UDS_SEND_MSG *)malloc(sizeof(UDS_SEND_MSG) + iSize);
+    if (pstMsg == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        releaseUdsSharedMemory(pstUdsServer, iClientIndex, iSize);
+        return -1;
+    }
+    pstMsg->uiGeneration = uiGeneration;
+    pstMsg->iLength = iSize;
+    memcpy(pstMsg->chData, pchData, iSize);
+    pushUdsMpscQueue(&pstUdsServer->pstClients[iClientIndex].stSendMpsc, &pstMsg->stNode);
+    signalUdsSend(pstUdsServer, iClientIndex);
+    return 0;
+}
+
+UDS_SEND_MSG* popUdsSendMsg(UDS_SERVER *pstUdsServer, int iClientIndex)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+    UDS_MPSC_NODE *pstNode;
+
+    while ((pstNode = popUdsMpscQueue(&pstClient->stSendMpsc)) != NULL) {
+        UDS_SEND_MSG *pstMsg = (UDS_SEND_MSG *)pstNode;
+        releaseUdsSharedMemory(pstUdsServer, iClientIndex, pstMsg->iLength);
+        if (pstClient->iActive && pstMsg->uiGeneration == pstClient->uiGeneration)
+            return pstMsg;
+        __atomic_add_fetch(&pstUdsServer->stStats.ullStaleSends, 1, __ATOMIC_RELAXED);
+        free(pstMsg);
+    }
+    return NULL;
+}
+
+void discardUdsSendMsgs(UDS_SERVER *pstUdsServer, int iClientIndex)
+{
+    UDS_MPSC_NODE *pstNode;
+
+    while ((pstNode = popUdsMpscQueue(&pstUdsServer->pstClients[iClientIndex].stSendMpsc)) != NULL) {
+        releaseUdsSharedMemory(pstUdsServer, iClientIndex, ((UDS_SEND_MSG *)pstNode)->iLength);
+        free(pstNode);
+    }
+}
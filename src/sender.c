@@ -7,6 +7,9 @@
  * 송신 처리 루틴을 정의합니다.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include "uds-server.h"
 #include "uds.h"
 #include <unistd.h>
@@ -14,25 +17,228 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <queue.h>
+#include <poll.h>
+
+#define SEND_IDLE_USEC  (5*1000)    ///< 송신할 데이터가 없을 때의 대기 시간(us)
+#define UDS_SEND_BATCH  16          ///< 한 번 순회할 때 클라이언트당 MPSC 큐에서 꺼내는 최대 메시지 수
+
+/**
+ * @brief 클라이언트 소켓으로 전송
+ *
+ * 송신 정체 감지가 설정되어 있으면 send() 시작 시각만 기록해 두고,
+ * 정체 감지 타이머가 이를 보고 막힌 소켓을 끊어 풀려나게 합니다.
+ * 타이머는 백로그가 생겨 처음 보낼 때 등록하고, 순회 끝에 백로그가 비었으면 취소합니다.
+ */
+static void sendClientData(UDS_SERVER *pstUdsServer, int iClientIndex, const char *pchData, int iLength)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+    int iStallMsec = pstUdsServer->stConfig.iSendStallMsec;
+
+    if (iStallMsec > 0) {
+        updateUdsStallTimer(pstUdsServer, iClientIndex, 1);
+        __atomic_store_n(&pstClient->ullSendStartUsec, getUdsMonotonicUsec(), __ATOMIC_RELAXED);
+    }
+    udsSendMsg(pstClient->iSock, pchData, iLength);
+    if (iStallMsec > 0)
+        __atomic_store_n(&pstClient->ullSendStartUsec, 0, __ATOMIC_RELAXED);
+}
+
+static void flushCoalesceBuffer(UDS_SERVER *pstUdsServer, int iClientIndex)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+
+    if (pstClient->iCoalesceLen > 0) {
+        sendClientData(pstUdsServer, iClientIndex, pstClient->pchCoalesceBuf, pstClient->iCoalesceLen);
+        pstClient->iCoalesceLen = 0;
+    }
+}
+
+/**
+ * @brief 메시지 하나를 병합 버퍼에 붙이거나, 버퍼보다 크면 바로 전송
+ */
+static void coalesceClientData(UDS_SERVER *pstUdsServer, int iClientIndex, const char *pchData, int iSendSize,
+                               unsigned long long ullNowUsec)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+
+    if (pstClient->iCoalesceLen + iSendSize > pstClient->iCoalesceMaxBytes)
+        flushCoalesceBuffer(pstUdsServer, iClientIndex);
+    if (iSendSize >= pstClient->iCoalesceMaxBytes) {
+        sendClientData(pstUdsServer, iClientIndex, pchData, iSendSize);
+    } else {
+        if (pstClient->iCoalesceLen == 0)
+            pstClient->ullCoalesceStartUsec = ullNowUsec;
+        memcpy(pstClient->pchCoalesceBuf + pstClient->iCoalesceLen, pchData, iSendSize);
+        pstClient->iCoalesceLen += iSendSize;
+    }
+}
+
+/**
+ * @brief 병합 모드 클라이언트의 송신 큐를 병합 버퍼로 옮기고 필요 시 전송
+ *
+ * 버퍼에 데이터가 남아 기한만 기다리는 동안에는 piSent를 건드리지 않으므로,
+ * 바쁜 대기 송신 스레드는 뮤텍스를 다시 잡지 않고 반환한 기한까지 기다린다.
+ *
+ * @param piSent 큐에서 메시지를 꺼냈거나 버퍼를 내보냈으면 1로 설정
+ * @return 다음 플러시 기한까지 남은 시간(us), 대기 중인 데이터가 없으면 -1
+ */
+static long long coalesceClient(UDS_SERVER *pstUdsServer, int iClientIndex, unsigned long long ullNowUsec, int *piSent)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+    UDS_SEND_MSG *pstMsg;
+
+    while (!queueIsEmpty(&pstClient->stSendQueue)) {
+        void* pvData = 0;
+        int iSendSize = queuePop(&pstClient->stSendQueue, &pvData);
+        if (pvData == NULL)
+            break;
+        releaseUdsMemory(pstUdsServer, iClientIndex, UDS_QUEUE_SEND, iSendSize);
+        coalesceClientData(pstUdsServer, iClientIndex, (char*)pvData, iSendSize, ullNowUsec);
+        free(pvData);
+        *piSent = 1;
+    }
+    for (int i = 0; i < UDS_SEND_BATCH && (pstMsg = popUdsSendMsg(pstUdsServer, iClientIndex)) != NULL; ++i) {
+        coalesceClientData(pstUdsServer, iClientIndex, pstMsg->chData, pstMsg->iLength, ullNowUsec);
+        free(pstMsg);
+        *piSent = 1;
+    }
+
+    if (pstClient->iCoalesceLen == 0)
+        return -1;
+
+    unsigned long long ullDeadline = pstClient->ullCoalesceStartUsec + pstClient->iCoalesceDelayUsec;
+    if (pstClient->iCoalesceLen >= pstClient->iCoalesceMaxBytes || ullNowUsec >= ullDeadline) {
+        flushCoalesceBuffer(pstUdsServer, iClientIndex);
+        *piSent = 1;
+        return -1;
+    }
+    return (long long)(ullDeadline - ullNowUsec);
+}
+
+/**
+ * @brief 송신 스레드가 맡은 슬롯들의 송신 순번 합
+ *
+ * 생산자는 자기 슬롯의 순번만 올리므로 서로 다른 클라이언트로 보내는 생산자끼리 다투지 않는다.
+ */
+static unsigned long loadSendSeq(UDS_SERVER_THREAD *pstThread, int iMemOrder)
+{
+    UDS_SERVER *pstUdsServer = pstThread->pstServer;
+    unsigned long ulSeq = 0;
+
+    for (int i = pstThread->iIndex; i < pstUdsServer->iMaxClients; i += pstThread->iCount)
+        ulSeq += __atomic_load_n(&pstUdsServer->pstClients[i].ulSendSeq, iMemOrder);
+    return ulSeq;
+}
+
+/**
+ * @brief 다음 순회까지 wake 파이프에서 잠듦
+ *
+ * 잠든다고 표시한 뒤 송신 순번을 다시 확인하므로, 그 사이에 들어온 병합 대상
+ * 메시지를 넣은 쪽은 표시를 보고 반드시 깨운다.
+ */
+static void sleepSendThread(UDS_SERVER_THREAD *pstThread, unsigned long ulSeq, long long llSleepUsec)
+{
+    struct pollfd stWake = { pstThread->aiWakeFd[0], POLLIN, 0 };
+    struct timespec stTimeout = { llSleepUsec / 1000000, (llSleepUsec % 1000000) * 1000 };
+
+    __atomic_store_n(&pstThread->iSleeping, 1, __ATOMIC_SEQ_CST);
+    if (loadSendSeq(pstThread, __ATOMIC_SEQ_CST) == ulSeq
+     && ppoll(&stWake, 1, &stTimeout, NULL) > 0) {
+        char chDrain[64];
+        while (read(pstThread->aiWakeFd[0], chDrain, sizeof(chDrain)) > 0)
+            ;
+    }
+    __atomic_store_n(&pstThread->iSleeping, 0, __ATOMIC_RELAXED);
+}
+
+void signalUdsSend(UDS_SERVER *pstUdsServer, int iClientIndex)
+{
+    __atomic_add_fetch(&pstUdsServer->pstClients[iClientIndex].ulSendSeq, 1, __ATOMIC_SEQ_CST);
+    // 병합 기한은 꺼낸 시각부터 재므로, 잠든 송신 스레드를 바로 깨워 넣은 시각에 맞춘다
+    if (__atomic_load_n(&pstUdsServer->pstClients[iClientIndex].iCoalesceMaxBytes, __ATOMIC_RELAXED) > 0)
+        wakeUdsSendThread(pstUdsServer, iClientIndex);
+}
 
 void* sendThread(void* arg) 
 {
-    UDS_SERVER* pstUdsServer = (UDS_SERVER *)arg;
+    UDS_SERVER_THREAD* pstThread = (UDS_SERVER_THREAD *)arg;
+    UDS_SERVER* pstUdsServer = pstThread->pstServer;
     int iSendSize;
-    while (1) {
+    int iBusyPollUsec = pstUdsServer->stConfig.iBusyPollUsec;
+    unsigned long long ullLastActiveUsec = getUdsMonotonicUsec();
+    while (pstUdsServer->iRunning) {
+        long long llSleepUsec = SEND_IDLE_USEC;
+        int iSent = 0;
+        unsigned long long ullNowUsec = getUdsMonotonicUsec();
+        // 순회 전에 읽어 두어야 순회 중에 들어온 일도 놓치지 않는다
+        unsigned long ulSeq = loadSendSeq(pstThread, __ATOMIC_ACQUIRE);
         pthread_mutex_lock(&pstUdsServer->mutex);
-        for (int i = 0; i < pstUdsServer->iMaxClients; ++i) {            
-            if (pstUdsServer->pstClients[i].iActive && !queueIsEmpty(&(pstUdsServer->pstClients[i].stSendQueue))) {
-                if(!queueIsEmpty(&(pstUdsServer->pstClients[i].stSendQueue))){
+        for (int i = pstThread->iIndex; i < pstUdsServer->iMaxClients; i += pstThread->iCount) {
+            CLIENT *pstClient = &pstUdsServer->pstClients[i];
+            if (!pstClient->iActive) {
+                // 연결이 끊긴 뒤 늦게 들어온 메시지가 예산을 붙잡고 있지 않도록 버린다
+                if (!isUdsMpscQueueEmpty(&pstClient->stSendMpsc))
+                    discardUdsSendMsgs(pstUdsServer, i);
+                continue;
+            }
+            if (__atomic_exchange_n(&pstClient->iHeartbeatDue, 0, __ATOMIC_ACQUIRE)) {
+                // 병합 중인 데이터를 먼저 내보내 하트비트가 메시지 중간에 끼지 않게 한다
+                flushCoalesceBuffer(pstUdsServer, i);
+                sendClientData(pstUdsServer, i, (const char*)pstUdsServer->stConfig.pvHeartbeatData,
+                               pstUdsServer->stConfig.iHeartbeatSize);
+                pstUdsServer->stStats.ullHeartbeats++;
+                iSent = 1;
+            }
+            if (pstClient->iCoalesceMaxBytes > 0) {
+                long long llRemainUsec = coalesceClient(pstUdsServer, i, ullNowUsec, &iSent);
+                if (llRemainUsec >= 0 && llRemainUsec < llSleepUsec)
+                    llSleepUsec = llRemainUsec;
+            } else {
+                if (!queueIsEmpty(&(pstClient->stSendQueue))) {
                     void* pvData = 0;
-                    iSendSize = queuePop(&(pstUdsServer->pstClients[i].stSendQueue), &pvData);
-                    udsSendMsg(pstUdsServer->pstClients[i].iSock, (char*)pvData, iSendSize);
+                    iSendSize = queuePop(&(pstClient->stSendQueue), &pvData);
+                    releaseUdsMemory(pstUdsServer, i, UDS_QUEUE_SEND, iSendSize);
+                    sendClientData(pstUdsServer, i, (char*)pvData, iSendSize);
                     free(pvData);
+                    iSent = 1;
                 }
+                UDS_SEND_MSG *pstMsg;
+                int iBatch = 0;
+                while (iBatch < UDS_SEND_BATCH && (pstMsg = popUdsSendMsg(pstUdsServer, i)) != NULL) {
+                    sendClientData(pstUdsServer, i, pstMsg->chData, pstMsg->iLength);
+                    free(pstMsg);
+                    iBatch++;
+                    iSent = 1;
+                }
+                // 배치를 다 채웠으면 더 남아 있을 수 있으므로 쉬지 않고 다음 순회
+                if (iBatch == UDS_SEND_BATCH)
+                    llSleepUsec = 0;
             }
+            if (pstClient->iStallArmed && pstClient->iCoalesceLen == 0 && queueIsEmpty(&pstClient->stSendQueue)
+             && isUdsMpscQueueEmpty(&pstClient->stSendMpsc))
+                updateUdsStallTimer(pstUdsServer, i, 0);
         }
         pthread_mutex_unlock(&pstUdsServer->mutex);
-        usleep(5*1000); // 5ms
+
+        if (iBusyPollUsec > 0) {
+            // 바쁜 대기 모드: 처리할 것이 있었으면 바로 다음 순회, 유휴가 예산을 넘으면 블로킹
+            if (iSent) {
+                ullLastActiveUsec = ullNowUsec;
+                continue;
+            }
+            unsigned long long ullSpinEndUsec = ullLastActiveUsec + iBusyPollUsec;
+            if (ullNowUsec < ullSpinEndUsec) {
+                // 뮤텍스 없이 송신 순번만 보다가, 바뀌거나 병합 기한이 되면 다시 순회한다
+                if (ullSpinEndUsec > ullNowUsec + llSleepUsec)
+                    ullSpinEndUsec = ullNowUsec + llSleepUsec;
+                while (loadSendSeq(pstThread, __ATOMIC_ACQUIRE) == ulSeq
+                    && getUdsMonotonicUsec() < ullSpinEndUsec)
+                    udsCpuRelax();
+                continue;
+            }
+        }
+        if (llSleepUsec > 0)
+            sleepSendThread(pstThread, ulSeq, llSleepUsec);
     }
     return NULL;
 }
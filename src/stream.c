@@ -0,0 +1,352 @@
+/**
+ * @file stream.c
+ * @brief 대용량 메시지 스트리밍 수신
+ *
+ * 이 파일은 길이 헤더가 붙은 프레임을 고정 크기 청크 체인으로 수신하고,
+ * 소비자가 마지막 바이트 도착 전부터 iovec 단위로 읽을 수 있게 하는
+ * 청크 풀과 메시지 처리 루틴을 정의합니다.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "uds-server.h"
+#include "uds-stream.h"
+#include <endian.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+
+void initUdsChunkPool(UDS_CHUNK_POOL *pstPool, int iMaxFree)
+{
+    pthread_mutex_init(&pstPool->mutex, NULL);
+    pstPool->pstFree = NULL;
+    pstPool->iFreeCount = 0;
+    pstPool->iMaxFree = iMaxFree;
+    pstPool->ullInUseBytes = 0;
+    pstPool->pfnRelease = NULL;
+    pstPool->pvReleaseArg = NULL;
+}
+
+void destroyUdsChunkPool(UDS_CHUNK_POOL *pstPool)
+{
+    pthread_mutex_lock(&pstPool->mutex);
+    while (pstPool->pstFree != NULL) {
+        UDS_CHUNK *pstChunk = pstPool->pstFree;
+        pstPool->pstFree = pstChunk->pstNext;
+        free(pstChunk);
+    }
+    pstPool->iFreeCount = 0;
+    pthread_mutex_unlock(&pstPool->mutex);
+    pthread_mutex_destroy(&pstPool->mutex);
+}
+
+static UDS_CHUNK* allocUdsChunk(UDS_CHUNK_POOL *pstPool)
+{
+    UDS_CHUNK *pstChunk = NULL;
+
+    pthread_mutex_lock(&pstPool->mutex);
+    if (pstPool->pstFree != NULL) {
+        pstChunk = pstPool->pstFree;
+        pstPool->pstFree = pstChunk->pstNext;
+        pstPool->iFreeCount--;
+    }
+    pthread_mutex_unlock(&pstPool->mutex);
+
+    if (pstChunk == NULL)
+        pstChunk = (UDS_CHUNK *)malloc(sizeof(UDS_CHUNK));
+    if (pstChunk != NULL) {
+        pstChunk->pstNext = NULL;
+        pstChunk->iLength = 0;
+    }
+    return pstChunk;
+}
+
+static void freeUdsChunk(UDS_CHUNK_POOL *pstPool, UDS_CHUNK *pstChunk)
+{
+    __atomic_sub_fetch(&pstPool->ullInUseBytes, UDS_STREAM_CHUNK_SIZE, __ATOMIC_RELAXED);
+    pthread_mutex_lock(&pstPool->mutex);
+    if (pstPool->iFreeCount < pstPool->iMaxFree) {
+        pstChunk->pstNext = pstPool->pstFree;
+        pstPool->pstFree = pstChunk;
+        pstPool->iFreeCount++;
+        pstChunk = NULL;
+    }
+    pthread_mutex_unlock(&pstPool->mutex);
+    free(pstChunk);
+}
+
+static UDS_STREAM_MSG* createUdsStreamMsg(UDS_CHUNK_POOL *pstPool, unsigned long long ullLength,
+                                          unsigned long long *pullOwnerBytes)
+{
+    UDS_STREAM_MSG *pstMsg = (UDS_STREAM_MSG *)malloc(sizeof(UDS_STREAM_MSG));
+    if (pstMsg == NULL)
+        return NULL;
+
+    pstMsg->ullLength = ullLength;
+    pstMsg->ullReceived = 0;
+    pstMsg->iState = ullLength == 0 ? UDS_STREAM_COMPLETE : UDS_STREAM_RECEIVING;
+    pstMsg->pstHead = NULL;
+    pstMsg->pstTail = NULL;
+    pstMsg->iRefCount = 2;  // 수신 스레드 + 소비자
+    pstMsg->pstPool = pstPool;
+    pstMsg->pullOwnerBytes = pullOwnerBytes;
+    pthread_mutex_init(&pstMsg->mutex, NULL);
+    pthread_cond_init(&pstMsg->cond, NULL);
+    return pstMsg;
+}
+
+void udsStreamMsgRelease(UDS_STREAM_MSG *pstMsg)
+{
+    pthread_mutex_lock(&pstMsg->mutex);
+    int iRefCount = --pstMsg->iRefCount;
+    pthread_mutex_unlock(&pstMsg->mutex);
+    if (iRefCount > 0)
+        return;
+
+    UDS_CHUNK_POOL *pstPool = pstMsg->pstPool;
+    int iChunks = 0;
+    while (pstMsg->pstHead != NULL) {
+        UDS_CHUNK *pstChunk = pstMsg->pstHead;
+        pstMsg->pstHead = pstChunk->pstNext;
+        freeUdsChunk(pstPool, pstChunk);
+        iChunks++;
+    }
+    if (iChunks > 0)
+        __atomic_sub_fetch(pstMsg->pullOwnerBytes, (unsigned long long)iChunks * UDS_STREAM_CHUNK_SIZE, __ATOMIC_RELAXED);
+    pthread_cond_destroy(&pstMsg->cond);
+    pthread_mutex_destroy(&pstMsg->mutex);
+    free(pstMsg);
+    if (iChunks > 0 && pstPool->pfnRelease != NULL)
+        pstPool->pfnRelease(pstPool->pvReleaseArg);
+}
+
+int udsStreamMsgRead(UDS_STREAM_MSG *pstMsg, UDS_STREAM_CURSOR *pstCursor, struct iovec *pstIov, int iIovMax, int iTimeoutMsec)
+{
+    struct timespec stDeadline;
+    int iCount = 0;
+
+    clock_gettime(CLOCK_REALTIME, &stDeadline);
+    stDeadline.tv_sec += iTimeoutMsec / 1000;
+    stDeadline.tv_nsec += (long)(iTimeoutMsec % 1000) * 1000000L;
+    if (stDeadline.tv_nsec >= 1000000000L) {
+        stDeadline.tv_sec++;
+        stDeadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&pstMsg->mutex);
+    while (pstCursor->ullOffset >= pstMsg->ullReceived && pstMsg->iState == UDS_STREAM_RECEIVING) {
+        if (pthread_cond_timedwait(&pstMsg->cond, &pstMsg->mutex, &stDeadline) == ETIMEDOUT) {
+            pthread_mutex_unlock(&pstMsg->mutex);
+            return UDS_TIME_OUT;
+        }
+    }
+
+    if (pstCursor->ullOffset >= pstMsg->ullReceived) {
+        int iRet = pstMsg->iState == UDS_STREAM_COMPLETE ? 0 : -1;
+        pthread_mutex_unlock(&pstMsg->mutex);
+        return iRet;
+    }
+
+    if (pstCursor->pstChunk == NULL) {
+        pstCursor->pstChunk = pstMsg->pstHead;
+        pstCursor->iChunkOffset = 0;
+    }
+    while (iCount < iIovMax && pstCursor->ullOffset < pstMsg->ullReceived) {
+        UDS_CHUNK *pstChunk = pstCursor->pstChunk;
+        if (pstCursor->iChunkOffset == pstChunk->iLength) {
+            if (pstChunk->pstNext == NULL)
+                break;
+            pstCursor->pstChunk = pstChunk = pstChunk->pstNext;
+            pstCursor->iChunkOffset = 0;
+        }
+        size_t iLength = pstChunk->iLength - pstCursor->iChunkOffset;
+        pstIov[iCount].iov_base = pstChunk->chData + pstCursor->iChunkOffset;
+        pstIov[iCount].iov_len = iLength;
+        pstCursor->iChunkOffset += iLength;
+        pstCursor->ullOffset += iLength;
+        iCount++;
+    }
+    pthread_mutex_unlock(&pstMsg->mutex);
+    return iCount;
+}
+
+int udsSendStreamMsg(int iSock, const struct iovec *pstIov, int iIovCount)
+{
+    unsigned long long ullTotal = 0;
+    unsigned long long ullHeader;
+    struct iovec stIov[iIovCount + 1];
+    struct msghdr stMsg;
+    int iFirst = 0;
+
+    for (int i = 0; i < iIovCount; ++i) {
+        ullTotal += pstIov[i].iov_len;
+        stIov[i + 1] = pstIov[i];
+    }
+    ullHeader = htobe64(ullTotal);
+    stIov[0].iov_base = &ullHeader;
+    stIov[0].iov_len = sizeof(ullHeader);
+
+    while (iFirst <= iIovCount) {
+        memset(&stMsg, 0, sizeof(stMsg));
+        stMsg.msg_iov = &stIov[iFirst];
+        stMsg.msg_iovlen = iIovCount + 1 - iFirst;
+        ssize_t iSent = sendmsg(iSock, &stMsg, MSG_NOSIGNAL);
+        if (iSent < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("Stream send failed");
+            return -1;
+        }
+        // 부분 전송: 다 보낸 iovec은 건너뛰고 나머지의 시작 위치를 조정한다
+        while (iFirst <= iIovCount && (size_t)iSent >= stIov[iFirst].iov_len) {
+            iSent -= stIov[iFirst].iov_len;
+            iFirst++;
+        }
+        if (iFirst <= iIovCount) {
+            stIov[iFirst].iov_base = (char *)stIov[iFirst].iov_base + iSent;
+            stIov[iFirst].iov_len -= iSent;
+        }
+    }
+    return 0;
+}
+
+void abortUdsStreamRx(UDS_STREAM_RX *pstRx)
+{
+    UDS_STREAM_MSG *pstMsg = pstRx->pstMsg;
+
+    if (pstMsg != NULL) {
+        pthread_mutex_lock(&pstMsg->mutex);
+        pstMsg->iState = UDS_STREAM_ABORTED;
+        pthread_cond_broadcast(&pstMsg->cond);
+        pthread_mutex_unlock(&pstMsg->mutex);
+        udsStreamMsgRelease(pstMsg);
+    }
+    pstRx->pstMsg = NULL;
+    pstRx->iHeaderLen = 0;
+    pstRx->ullSkip = 0;
+}
+
+static int recvUdsStreamHeader(UDS_SERVER *pstUdsServer, int iClientIndex)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+    UDS_STREAM_RX *pstRx = &pstClient->stStreamRx;
+    unsigned long long ullLength;
+
+    int iRecvSize = recv(pstClient->iSock, pstRx->uchHeader + pstRx->iHeaderLen, UDS_STREAM_HEADER_SIZE - pstRx->iHeaderLen, 0);
+    if (iRecvSize <= 0)
+        return iRecvSize;
+    // 스트림 모드는 헤더를 포함한 원래 바이트열을 그대로 기록하여 재생 시 같은 프레임이 만들어지게 한다
+    captureUdsRecord(&pstUdsServer->stCapture, UDS_CAPTURE_DATA, iClientIndex, pstRx->uchHeader + pstRx->iHeaderLen, iRecvSize);
+    pstRx->iHeaderLen += iRecvSize;
+    if (pstRx->iHeaderLen < UDS_STREAM_HEADER_SIZE)
+        return iRecvSize;
+
+    pstRx->iHeaderLen = 0;
+    memcpy(&ullLength, pstRx->uchHeader, sizeof(ullLength));
+    ullLength = be64toh(ullLength);
+    if (ullLength > pstUdsServer->stConfig.ullStreamMaxSize) {
+        fprintf(stderr, "### FAIL %s():%d stream message too large (%llu) ###\n", __func__, __LINE__, ullLength);
+        return -1;
+    }
+
+    UDS_STREAM_MSG *pstMsg = createUdsStreamMsg(&pstUdsServer->stChunkPool, ullLength, &pstClient->ullChunkBytes);
+    if (pstMsg == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        pstRx->ullSkip = ullLength;
+        return iRecvSize;
+    }
+
+    pthread_mutex_lock(&pstUdsServer->mutex);
+    int iPushed = queuePush(&pstClient->stRecvQueue, pstMsg, sizeof(UDS_STREAM_MSG));
+    if (iPushed)
+        signalUdsRecv(pstUdsServer, iClientIndex);
+    pthread_mutex_unlock(&pstUdsServer->mutex);
+
+    if (!iPushed) {
+        fprintf(stderr, "### FAIL %s():%d recv queue full, dropping %llu bytes ###\n", __func__, __LINE__, ullLength);
+        udsStreamMsgRelease(pstMsg);
+        udsStreamMsgRelease(pstMsg);
+        pstRx->ullSkip = ullLength;
+    } else if (ullLength == 0) {
+        udsStreamMsgRelease(pstMsg);
+    } else {
+        pstRx->pstMsg = pstMsg;
+    }
+    return iRecvSize;
+}
+
+int recvUdsStream(UDS_SERVER *pstUdsServer, int iClientIndex)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+    UDS_STREAM_RX *pstRx = &pstClient->stStreamRx;
+    int iRecvSize;
+
+    if (pstRx->ullSkip > 0) {
+        char chDiscard[4096];
+        size_t iWant = pstRx->ullSkip < sizeof(chDiscard) ? (size_t)pstRx->ullSkip : sizeof(chDiscard);
+        iRecvSize = recv(pstClient->iSock, chDiscard, iWant, 0);
+        if (iRecvSize > 0) {
+            captureUdsRecord(&pstUdsServer->stCapture, UDS_CAPTURE_DATA, iClientIndex, chDiscard, iRecvSize);
+            pstRx->ullSkip -= iRecvSize;
+        }
+        return iRecvSize;
+    }
+
+    if (pstRx->pstMsg == NULL)
+        return recvUdsStreamHeader(pstUdsServer, iClientIndex);
+
+    UDS_STREAM_MSG *pstMsg = pstRx->pstMsg;
+    UDS_CHUNK *pstTail = pstMsg->pstTail;
+    if (pstTail == NULL || pstTail->iLength == UDS_STREAM_CHUNK_SIZE) {
+        pthread_mutex_lock(&pstUdsServer->mutex);
+        int iReserved = reserveUdsMemory(pstUdsServer, iClientIndex, UDS_QUEUE_CHUNK, UDS_STREAM_CHUNK_SIZE);
+        pthread_mutex_unlock(&pstUdsServer->mutex);
+        if (!iReserved)
+            return UDS_STREAM_PAUSED;
+
+        // 청크 풀 사용량은 reserveUdsMemory()가 이미 더했다
+        UDS_CHUNK *pstChunk = allocUdsChunk(pstMsg->pstPool);
+        if (pstChunk == NULL) {
+            fprintf(stderr, "Memory allocation failed\n");
+            __atomic_sub_fetch(&pstMsg->pstPool->ullInUseBytes, UDS_STREAM_CHUNK_SIZE, __ATOMIC_RELAXED);
+            return -1;
+        }
+        __atomic_add_fetch(pstMsg->pullOwnerBytes, UDS_STREAM_CHUNK_SIZE, __ATOMIC_RELAXED);
+        pthread_mutex_lock(&pstMsg->mutex);
+        if (pstTail == NULL)
+            pstMsg->pstHead = pstChunk;
+        else
+            pstTail->pstNext = pstChunk;
+        pstMsg->pstTail = pstTail = pstChunk;
+        pthread_mutex_unlock(&pstMsg->mutex);
+    }
+
+    // 청크의 빈 공간으로 직접 수신하되, 다음 프레임의 헤더까지 읽지 않도록 남은 길이로 제한한다
+    size_t iWant = UDS_STREAM_CHUNK_SIZE - pstTail->iLength;
+    unsigned long long ullRemain = pstMsg->ullLength - pstMsg->ullReceived;
+    if (ullRemain < iWant)
+        iWant = (size_t)ullRemain;
+    iRecvSize = recv(pstClient->iSock, pstTail->chData + pstTail->iLength, iWant, 0);
+    if (iRecvSize <= 0)
+        return iRecvSize;
+    captureUdsRecord(&pstUdsServer->stCapture, UDS_CAPTURE_DATA, iClientIndex, pstTail->chData + pstTail->iLength, iRecvSize);
+
+    pthread_mutex_lock(&pstMsg->mutex);
+    pstTail->iLength += iRecvSize;
+    pstMsg->ullReceived += iRecvSize;
+    int iComplete = pstMsg->ullReceived == pstMsg->ullLength;
+    if (iComplete)
+        pstMsg->iState = UDS_STREAM_COMPLETE;
+    pthread_cond_broadcast(&pstMsg->cond);
+    pthread_mutex_unlock(&pstMsg->mutex);
+
+    if (iComplete) {
+        pstRx->pstMsg = NULL;
+        udsStreamMsgRelease(pstMsg);
+    }
+    return iRecvSize;
+}
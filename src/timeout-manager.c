@@ -0,0 +1,123 @@
+/**
+ * @file timeout-manager.c
+ * @brief UDS 클라이언트 타이머 스레드
+ *
+ * 이 파일은 연결별 유휴 타임아웃, 하트비트, 송신 정체 감지 타이머의
+ * 만료 처리와 이를 구동하는 타이머 스레드 함수를 정의합니다.
+ */
+
+#include "uds-server.h"
+#include <stdio.h>
+#include <sys/socket.h>
+
+static long long expireUdsIdleTimer(UDS_TIMER *pstTimer)
+{
+    UDS_SERVER *pstUdsServer = (UDS_SERVER *)pstTimer->pvArg;
+    CLIENT *pstClient = &pstUdsServer->pstClients[pstTimer->iArg];
+    long long llTimeoutMsec = pstUdsServer->stConfig.iIdleTimeoutMsec;
+    unsigned long long ullLastUsec = __atomic_load_n(&pstClient->ullLastRecvUsec, __ATOMIC_RELAXED);
+    long long llIdleMsec = (long long)((getUdsMonotonicUsec() - ullLastUsec) / 1000ULL);
+
+    // 수신할 때마다 다시 등록하지 않고, 만료 시점에 마지막 수신 시각을 보고 남은 만큼 미룬다
+    if (llIdleMsec < llTimeoutMsec)
+        return llTimeoutMsec - llIdleMsec;
+    fprintf(stderr, "[Timer] Client %d idle for %lld ms, disconnecting\n", pstTimer->iArg, llIdleMsec);
+    __atomic_add_fetch(&pstUdsServer->stStats.ullIdleTimeouts, 1, __ATOMIC_RELAXED);
+    shutdown(pstClient->iSock, SHUT_RDWR);
+    return 0;
+}
+
+static long long expireUdsHeartbeatTimer(UDS_TIMER *pstTimer)
+{
+    UDS_SERVER *pstUdsServer = (UDS_SERVER *)pstTimer->pvArg;
+
+    // 서버 뮤텍스를 잡을 수 없으므로 전송은 송신 스레드에 맡긴다
+    __atomic_store_n(&pstUdsServer->pstClients[pstTimer->iArg].iHeartbeatDue, 1, __ATOMIC_RELEASE);
+    signalUdsSend(pstUdsServer, pstTimer->iArg);
+    return pstUdsServer->stConfig.iHeartbeatMsec;
+}
+
+static long long expireUdsStallTimer(UDS_TIMER *pstTimer)
+{
+    UDS_SERVER *pstUdsServer = (UDS_SERVER *)pstTimer->pvArg;
+    CLIENT *pstClient = &pstUdsServer->pstClients[pstTimer->iArg];
+    long long llStallMsec = pstUdsServer->stConfig.iSendStallMsec;
+    unsigned long long ullStartUsec = __atomic_load_n(&pstClient->ullSendStartUsec, __ATOMIC_RELAXED);
+
+    // 송신할 데이터가 쌓여 있는 동안만 등록되어 있으며, send()마다 등록/취소하지 않고
+    // 주기마다 진행 중인 send()의 시작 시각을 보고 남은 만큼 미룬다
+    if (ullStartUsec == 0)
+        return llStallMsec;
+    long long llSendMsec = (long long)((getUdsMonotonicUsec() - ullStartUsec) / 1000ULL);
+    if (llSendMsec < llStallMsec)
+        return llStallMsec - llSendMsec;
+
+    // 막혀 있는 send()가 에러로 돌아오도록 소켓을 끊는다
+    fprintf(stderr, "[Timer] Client %d send stalled for %lld ms, disconnecting\n", pstTimer->iArg, llSendMsec);
+    __atomic_add_fetch(&pstUdsServer->stStats.ullSendStalls, 1, __ATOMIC_RELAXED);
+    shutdown(pstClient->iSock, SHUT_RDWR);
+    return 0;
+}
+
+void initUdsClientTimers(UDS_SERVER *pstUdsServer, int iClientIndex)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+
+    initUdsTimer(&pstClient->stIdleTimer, expireUdsIdleTimer, pstUdsServer, iClientIndex);
+    initUdsTimer(&pstClient->stHeartbeatTimer, expireUdsHeartbeatTimer, pstUdsServer, iClientIndex);
+    initUdsTimer(&pstClient->stStallTimer, expireUdsStallTimer, pstUdsServer, iClientIndex);
+    pstClient->ullLastRecvUsec = 0;
+    pstClient->ullSendStartUsec = 0;
+    pstClient->iHeartbeatDue = 0;
+    pstClient->iStallArmed = 0;
+}
+
+void startUdsClientTimers(UDS_SERVER *pstUdsServer, int iClientIndex)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+
+    pstClient->ullLastRecvUsec = getUdsMonotonicUsec();
+    pstClient->ullSendStartUsec = 0;
+    pstClient->iHeartbeatDue = 0;
+    if (pstUdsServer->stConfig.iIdleTimeoutMsec > 0)
+        armUdsTimer(&pstUdsServer->stTimerWheel, &pstClient->stIdleTimer, pstUdsServer->stConfig.iIdleTimeoutMsec);
+    if (pstUdsServer->stConfig.iHeartbeatMsec > 0)
+        armUdsTimer(&pstUdsServer->stTimerWheel, &pstClient->stHeartbeatTimer, pstUdsServer->stConfig.iHeartbeatMsec);
+    // 송신 정체 감지 타이머는 송신 스레드가 백로그를 발견할 때 등록한다
+    pstClient->iStallArmed = 0;
+}
+
+void stopUdsClientTimers(UDS_SERVER *pstUdsServer, int iClientIndex)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+
+    cancelUdsTimer(&pstUdsServer->stTimerWheel, &pstClient->stIdleTimer);
+    cancelUdsTimer(&pstUdsServer->stTimerWheel, &pstClient->stHeartbeatTimer);
+    cancelUdsTimer(&pstUdsServer->stTimerWheel, &pstClient->stStallTimer);
+    pstClient->iStallArmed = 0;
+}
+
+void updateUdsStallTimer(UDS_SERVER *pstUdsServer, int iClientIndex, int iBacklog)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+
+    if (pstUdsServer->stConfig.iSendStallMsec <= 0 || pstClient->iStallArmed == iBacklog)
+        return;
+    pstClient->iStallArmed = iBacklog;
+    if (iBacklog)
+        armUdsTimer(&pstUdsServer->stTimerWheel, &pstClient->stStallTimer, pstUdsServer->stConfig.iSendStallMsec);
+    else
+        cancelUdsTimer(&pstUdsServer->stTimerWheel, &pstClient->stStallTimer);
+}
+
+void* timerThread(void* arg)
+{
+    UDS_SERVER_THREAD* pstThread = (UDS_SERVER_THREAD *)arg;
+    UDS_SERVER* pstUdsServer = pstThread->pstServer;
+
+    while (pstUdsServer->iRunning) {
+        advanceUdsTimerWheel(&pstUdsServer->stTimerWheel);
+        waitUdsTimerWheel(&pstUdsServer->stTimerWheel, UDS_TIMER_MAX_WAIT_MSEC);
+    }
+    return NULL;
+}
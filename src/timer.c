@@ -0,0 +1,257 @@
+/**
+ * @file timer.c
+ * @brief 계층형 타이머 휠
+ *
+ * 이 파일은 연결별 유휴 타임아웃, 하트비트, 송신 정체 감지에 쓰이는
+ * 계층형 타이머 휠의 등록/취소/진행 루틴을 정의합니다.
+ * 등록과 취소는 O(1)이며, 틱 처리 비용은 등록된 타이머 수와 무관합니다.
+ */
+
+#include "uds-timer.h"
+#include "uds-server.h"
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+
+#define UDS_TIMER_SLOT_MASK     (UDS_TIMER_WHEEL_SLOTS - 1)
+#define UDS_TIMER_LEVEL_SHIFT(iLevel) (UDS_TIMER_WHEEL_BITS * (iLevel))
+#define UDS_TIMER_RANGE_TICKS   (1ULL << UDS_TIMER_LEVEL_SHIFT(UDS_TIMER_WHEEL_LEVELS))
+
+static unsigned long long getUdsTimerNowTick(UDS_TIMER_WHEEL *pstWheel)
+{
+    return (getUdsMonotonicUsec() - pstWheel->ullStartUsec) / (UDS_TIMER_TICK_MSEC * 1000ULL);
+}
+
+static void initUdsTimerList(UDS_TIMER *pstHead)
+{
+    pstHead->pstNext = pstHead;
+    pstHead->pstPrev = pstHead;
+}
+
+static void unlinkUdsTimer(UDS_TIMER *pstTimer)
+{
+    pstTimer->pstPrev->pstNext = pstTimer->pstNext;
+    pstTimer->pstNext->pstPrev = pstTimer->pstPrev;
+    pstTimer->pstNext = pstTimer->pstPrev = NULL;
+}
+
+static void linkUdsTimer(UDS_TIMER *pstHead, UDS_TIMER *pstTimer)
+{
+    pstTimer->pstPrev = pstHead->pstPrev;
+    pstTimer->pstNext = pstHead;
+    pstHead->pstPrev->pstNext = pstTimer;
+    pstHead->pstPrev = pstTimer;
+}
+
+/**
+ * @brief 남은 틱 수에 맞는 레벨과 슬롯에 타이머를 연결
+ *
+ * 휠 범위를 넘는 타이머는 최상위 레벨의 가장 먼 슬롯에 두었다가
+ * 내려올 때 다시 배치합니다.
+ */
+static void insertUdsTimer(UDS_TIMER_WHEEL *pstWheel, UDS_TIMER *pstTimer)
+{
+    unsigned long long ullExpire = pstTimer->ullExpireTick;
+    int iLevel = 0;
+
+    if (ullExpire < pstWheel->ullCurrentTick)
+        ullExpire = pstWheel->ullCurrentTick;
+    if (ullExpire - pstWheel->ullCurrentTick >= UDS_TIMER_RANGE_TICKS)
+        ullExpire = pstWheel->ullCurrentTick + UDS_TIMER_RANGE_TICKS - 1;
+    while (iLevel < UDS_TIMER_WHEEL_LEVELS - 1
+        && ullExpire - pstWheel->ullCurrentTick >= (1ULL << UDS_TIMER_LEVEL_SHIFT(iLevel + 1)))
+        iLevel++;
+    linkUdsTimer(&pstWheel->astSlots[iLevel][(ullExpire >> UDS_TIMER_LEVEL_SHIFT(iLevel)) & UDS_TIMER_SLOT_MASK], pstTimer);
+}
+
+/**
+ * @brief 상위 레벨 슬롯 하나의 타이머를 남은 시간에 맞게 다시 배치
+ *
+ * @return 슬롯 인덱스 (0이면 그 위 레벨도 내려야 함)
+ */
+static int cascadeUdsTimers(UDS_TIMER_WHEEL *pstWheel, int iLevel)
+{
+    int iIndex = (pstWheel->ullCurrentTick >> UDS_TIMER_LEVEL_SHIFT(iLevel)) & UDS_TIMER_SLOT_MASK;
+    UDS_TIMER *pstHead = &pstWheel->astSlots[iLevel][iIndex];
+    UDS_TIMER stPending;
+
+    if (pstHead->pstNext == pstHead)
+        return iIndex;
+    // 슬롯 목록을 통째로 떼어 낸 뒤 하나씩 다시 넣는다
+    stPending.pstNext = pstHead->pstNext;
+    stPending.pstPrev = pstHead->pstPrev;
+    stPending.pstNext->pstPrev = &stPending;
+    stPending.pstPrev->pstNext = &stPending;
+    initUdsTimerList(pstHead);
+    while (stPending.pstNext != &stPending) {
+        UDS_TIMER *pstTimer = stPending.pstNext;
+        unlinkUdsTimer(pstTimer);
+        insertUdsTimer(pstWheel, pstTimer);
+    }
+    return iIndex;
+}
+
+void initUdsTimerWheel(UDS_TIMER_WHEEL *pstWheel)
+{
+    pthread_mutex_init(&pstWheel->mutex, NULL);
+    pthread_cond_init(&pstWheel->cond, NULL);
+    pstWheel->ullStartUsec = getUdsMonotonicUsec();
+    pstWheel->ullCurrentTick = 0;
+    pstWheel->ullWakeTick = ULLONG_MAX;
+    pstWheel->iArmedCount = 0;
+    for (int iLevel = 0; iLevel < UDS_TIMER_WHEEL_LEVELS; ++iLevel) {
+        for (int iSlot = 0; iSlot < UDS_TIMER_WHEEL_SLOTS; ++iSlot)
+            initUdsTimerList(&pstWheel->astSlots[iLevel][iSlot]);
+    }
+}
+
+void destroyUdsTimerWheel(UDS_TIMER_WHEEL *pstWheel)
+{
+    pthread_cond_destroy(&pstWheel->cond);
+    pthread_mutex_destroy(&pstWheel->mutex);
+}
+
+void initUdsTimer(UDS_TIMER *pstTimer, UDS_TIMER_FN pfnExpire, void *pvArg, int iArg)
+{
+    memset(pstTimer, 0, sizeof(UDS_TIMER));
+    pstTimer->pfnExpire = pfnExpire;
+    pstTimer->pvArg = pvArg;
+    pstTimer->iArg = iArg;
+}
+
+void armUdsTimer(UDS_TIMER_WHEEL *pstWheel, UDS_TIMER *pstTimer, long long llDelayMsec)
+{
+    unsigned long long ullDelayTicks = llDelayMsec > 0 ? (llDelayMsec + UDS_TIMER_TICK_MSEC - 1) / UDS_TIMER_TICK_MSEC : 0;
+
+    pthread_mutex_lock(&pstWheel->mutex);
+    unsigned long long ullBase = getUdsTimerNowTick(pstWheel);
+    if (ullBase < pstWheel->ullCurrentTick)
+        ullBase = pstWheel->ullCurrentTick;
+    if (pstTimer->iArmed)
+        unlinkUdsTimer(pstTimer);
+    else
+        pstWheel->iArmedCount++;
+    pstTimer->iArmed = 1;
+    pstTimer->ullExpireTick = ullBase + ullDelayTicks;
+    insertUdsTimer(pstWheel, pstTimer);
+    if (pstTimer->ullExpireTick < pstWheel->ullWakeTick)
+        pthread_cond_signal(&pstWheel->cond);
+    pthread_mutex_unlock(&pstWheel->mutex);
+}
+
+void cancelUdsTimer(UDS_TIMER_WHEEL *pstWheel, UDS_TIMER *pstTimer)
+{
+    pthread_mutex_lock(&pstWheel->mutex);
+    if (pstTimer->iArmed) {
+        unlinkUdsTimer(pstTimer);
+        pstTimer->iArmed = 0;
+        pstWheel->iArmedCount--;
+    }
+    pthread_mutex_unlock(&pstWheel->mutex);
+}
+
+int advanceUdsTimerWheel(UDS_TIMER_WHEEL *pstWheel)
+{
+    int iExpired = 0;
+
+    pthread_mutex_lock(&pstWheel->mutex);
+    unsigned long long ullNowTick = getUdsTimerNowTick(pstWheel);
+    if (pstWheel->iArmedCount == 0 && pstWheel->ullCurrentTick <= ullNowTick) {
+        // 등록된 타이머가 없으면 내려 보낼 것도 없으므로 바로 건너뛴다
+        pstWheel->ullCurrentTick = ullNowTick + 1;
+    }
+    while (pstWheel->ullCurrentTick <= ullNowTick) {
+        int iIndex = pstWheel->ullCurrentTick & UDS_TIMER_SLOT_MASK;
+        if (iIndex == 0) {
+            for (int iLevel = 1; iLevel < UDS_TIMER_WHEEL_LEVELS && cascadeUdsTimers(pstWheel, iLevel) == 0; ++iLevel)
+                ;
+        }
+
+        // 콜백이 다시 등록해도 남은 시간이 1틱 이상이므로 같은 슬롯으로 돌아오지 않는다
+        UDS_TIMER *pstHead = &pstWheel->astSlots[0][iIndex];
+        while (pstHead->pstNext != pstHead) {
+            UDS_TIMER *pstTimer = pstHead->pstNext;
+            unlinkUdsTimer(pstTimer);
+            pstTimer->iArmed = 0;
+            pstWheel->iArmedCount--;
+            iExpired++;
+
+            long long llRearmMsec = pstTimer->pfnExpire(pstTimer);
+            if (llRearmMsec > 0) {
+                unsigned long long ullTicks = (llRearmMsec + UDS_TIMER_TICK_MSEC - 1) / UDS_TIMER_TICK_MSEC;
+                pstTimer->ullExpireTick = pstWheel->ullCurrentTick + ullTicks;
+                pstTimer->iArmed = 1;
+                pstWheel->iArmedCount++;
+                insertUdsTimer(pstWheel, pstTimer);
+            }
+        }
+        pstWheel->ullCurrentTick++;
+    }
+    pthread_mutex_unlock(&pstWheel->mutex);
+    return iExpired;
+}
+
+/**
+ * @brief 다음으로 타이머가 만료되거나 내려올 수 있는 가장 이른 틱
+ *
+ * 각 레벨에서 현재 위치 이후 처음으로 비어 있지 않은 슬롯만 확인하므로
+ * 비용은 레벨 수 x 슬롯 수로 고정됩니다. 상위 레벨의 현재 슬롯은 이번 틱에 내려오거나
+ * (현재 틱이 그 슬롯의 시작일 때) 한 바퀴 뒤에 내려옵니다. 휠 뮤텍스를 잡고 호출해야 합니다.
+ */
+static unsigned long long getUdsTimerNextTick(UDS_TIMER_WHEEL *pstWheel)
+{
+    unsigned long long ullNext = ULLONG_MAX;
+
+    if (pstWheel->iArmedCount == 0)
+        return ullNext;
+    for (int iLevel = 0; iLevel < UDS_TIMER_WHEEL_LEVELS; ++iLevel) {
+        int iShift = UDS_TIMER_LEVEL_SHIFT(iLevel);
+        unsigned long long ullLevelTick = pstWheel->ullCurrentTick >> iShift;
+        for (int j = 0; j < UDS_TIMER_WHEEL_SLOTS; ++j) {
+            UDS_TIMER *pstHead = &pstWheel->astSlots[iLevel][(ullLevelTick + j) & UDS_TIMER_SLOT_MASK];
+            if (pstHead->pstNext == pstHead)
+                continue;
+            unsigned long long ullTick = iLevel == 0 ? pstWheel->ullCurrentTick + j : (ullLevelTick + j) << iShift;
+            int iWrapped = ullTick < pstWheel->ullCurrentTick;
+            if (iWrapped)
+                ullTick += (unsigned long long)UDS_TIMER_WHEEL_SLOTS << iShift;
+            if (ullTick < ullNext)
+                ullNext = ullTick;
+            // 한 바퀴 뒤로 넘긴 현재 슬롯보다 뒤쪽 슬롯이 먼저 내려오므로 계속 찾는다
+            if (!iWrapped)
+                break;
+        }
+    }
+    return ullNext;
+}
+
+void waitUdsTimerWheel(UDS_TIMER_WHEEL *pstWheel, int iMaxMsec)
+{
+    pthread_mutex_lock(&pstWheel->mutex);
+    unsigned long long ullNowUsec = getUdsMonotonicUsec();
+    unsigned long long ullWakeTick = getUdsTimerNextTick(pstWheel);
+    unsigned long long ullMaxTick = (ullNowUsec - pstWheel->ullStartUsec + (unsigned long long)iMaxMsec * 1000ULL)
+                                  / (UDS_TIMER_TICK_MSEC * 1000ULL);
+    if (ullWakeTick > ullMaxTick)
+        ullWakeTick = ullMaxTick;
+
+    unsigned long long ullWakeUsec = pstWheel->ullStartUsec + ullWakeTick * UDS_TIMER_TICK_MSEC * 1000ULL;
+    if (ullWakeUsec > ullNowUsec) {
+        struct timespec stDeadline;
+        clock_gettime(CLOCK_REALTIME, &stDeadline);
+        unsigned long long ullNsec = stDeadline.tv_nsec + (ullWakeUsec - ullNowUsec) * 1000ULL;
+        stDeadline.tv_sec += ullNsec / 1000000000ULL;
+        stDeadline.tv_nsec = ullNsec % 1000000000ULL;
+        pstWheel->ullWakeTick = ullWakeTick;
+        pthread_cond_timedwait(&pstWheel->cond, &pstWheel->mutex, &stDeadline);
+        pstWheel->ullWakeTick = ULLONG_MAX;
+    }
+    pthread_mutex_unlock(&pstWheel->mutex);
+}
+
+void wakeUdsTimerWheel(UDS_TIMER_WHEEL *pstWheel)
+{
+    pthread_mutex_lock(&pstWheel->mutex);
+    pthread_cond_broadcast(&pstWheel->cond);
+    pthread_mutex_unlock(&pstWheel->mutex);
+}
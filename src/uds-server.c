@@ -1,30 +1,536 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include "uds-server.h"
+#include <sched.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <time.h>
 
-void startUdsServer(UDS_SERVER *pstUdsServer, char* pchUdsPath, int iUdsClientCount) 
+static void formatUdsThreadName(char *pchName, const UDS_THREAD_ATTR *pstAttr, int iIndex)
+{
+    char chBuf[UDS_THREAD_NAME_LEN + 16];
+    snprintf(chBuf, sizeof(chBuf), "%.*s-%d", UDS_THREAD_NAME_LEN - 1, pstAttr->chName, iIndex);
+    memcpy(pchName, chBuf, UDS_THREAD_NAME_LEN - 1);
+    pchName[UDS_THREAD_NAME_LEN - 1] = '\0';
+}
+
+static void applyUdsThreadAttr(UDS_SERVER_THREAD *pstThread)
+{
+    const UDS_THREAD_ATTR *pstAttr = pstThread->pstAttr;
+    char chName[UDS_THREAD_NAME_LEN];
+    cpu_set_t stCpuSet;
+    int iCpuCount = 0;
+
+    formatUdsThreadName(chName, pstAttr, pstThread->iIndex);
+
+    CPU_ZERO(&stCpuSet);
+    for (int iCpu = 0; iCpu < UDS_MAX_CPUS && iCpu < CPU_SETSIZE; ++iCpu) {
+        if (pstAttr->aulCpuMask[iCpu / (8 * sizeof(unsigned long))] & (1UL << (iCpu % (8 * sizeof(unsigned long))))) {
+            CPU_SET(iCpu, &stCpuSet);
+            iCpuCount++;
+        }
+    }
+    if (iCpuCount > 0 && pthread_setaffinity_np(pthread_self(), sizeof(stCpuSet), &stCpuSet) != 0)
+        fprintf(stderr, "[Thread] %s: CPU affinity failed\n", chName);
+
+    if (pstAttr->iSchedPolicy != SCHED_OTHER) {
+        struct sched_param stParam;
+        memset(&stParam, 0, sizeof(stParam));
+        stParam.sched_priority = pstAttr->iSchedPriority;
+        if (pthread_setschedparam(pthread_self(), pstAttr->iSchedPolicy, &stParam) != 0)
+            fprintf(stderr, "[Thread] %s: scheduling policy %d failed\n", chName, pstAttr->iSchedPolicy);
+    }
+
+    if (pstAttr->iNice != 0 && setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), pstAttr->iNice) != 0)
+        fprintf(stderr, "[Thread] %s: nice %d failed\n", chName, pstAttr->iNice);
+}
+
+static void wakeUdsThread(UDS_SERVER_THREAD *pstThread)
+{
+    char chWake = 0;
+    if (pstThread->aiWakeFd[1] >= 0 && write(pstThread->aiWakeFd[1], &chWake, 1) < 0 && errno != EAGAIN)
+        perror("Wake write failed");
+}
+
+static void* udsThreadEntry(void* arg)
+{
+    UDS_SERVER_THREAD *pstThread = (UDS_SERVER_THREAD *)arg;
+    applyUdsThreadAttr(pstThread);
+    return pstThread->pfnRoutine(pstThread);
+}
+
+static int spawnUdsThreads(UDS_SERVER *pstUdsServer, void* (*pfnRoutine)(void*), const UDS_THREAD_ATTR *pstAttr, int iCount)
+{
+    char chName[UDS_THREAD_NAME_LEN];
+
+    if (pfnRoutine == recvThread)
+        pstUdsServer->pstRecvThreads = &pstUdsServer->pstThreads[pstUdsServer->iThreadCount];
+    else if (pfnRoutine == sendThread)
+        pstUdsServer->pstSendThreads = &pstUdsServer->pstThreads[pstUdsServer->iThreadCount];
+    for (int i = 0; i < iCount; ++i) {
+        UDS_SERVER_THREAD *pstThread = &pstUdsServer->pstThreads[pstUdsServer->iThreadCount];
+        pstThread->pstServer = pstUdsServer;
+        pstThread->iIndex = i;
+        pstThread->iCount = iCount;
+        pstThread->pstAttr = pstAttr;
+        pstThread->pfnRoutine = pfnRoutine;
+        pstThread->aiWakeFd[0] = pstThread->aiWakeFd[1] = -1;
+        if (pfnRoutine == recvThread || pfnRoutine == sendThread || pfnRoutine == connectionManagerThread) {
+            if (pipe2(pstThread->aiWakeFd, O_NONBLOCK | O_CLOEXEC) == -1) {
+                perror("Wake pipe failed");
+                return -1;
+            }
+        }
+        if (pthread_create(&pstThread->stThread, NULL, udsThreadEntry, pstThread) != 0) {
+            perror("Thread create failed");
+            // 시작하지 못한 스레드는 iThreadCount에 들지 않아 haltUdsServerThreads()가 닫지 않는다
+            for (int j = 0; j < 2; ++j) {
+                if (pstThread->aiWakeFd[j] >= 0)
+                    close(pstThread->aiWakeFd[j]);
+                pstThread->aiWakeFd[j] = -1;
+            }
+            return -1;
+        }
+        pstThread->iStarted = 1;
+        formatUdsThreadName(chName, pstAttr, i);
+        pthread_setname_np(pstThread->stThread, chName);
+        pstUdsServer->iThreadCount++;
+    }
+    return 0;
+}
+
+static void initUdsThreadAttr(UDS_THREAD_ATTR *pstAttr, const char *pchName)
+{
+    memset(pstAttr, 0, sizeof(UDS_THREAD_ATTR));
+    pstAttr->iSchedPolicy = SCHED_OTHER;
+    snprintf(pstAttr->chName, sizeof(pstAttr->chName), "%s", pchName);
+}
+
+void initUdsServerConfig(UDS_SERVER_CONFIG *pstConfig, char* pchUdsPath, int iMaxClients)
+{
+    memset(pstConfig, 0, sizeof(UDS_SERVER_CONFIG));
+    pstConfig->pchUdsPath = pchUdsPath;
+    pstConfig->iMaxClients = iMaxClients;
+    pstConfig->pchDgramPath = NULL;
+    pstConfig->iRecvThreadCount = 1;
+    pstConfig->iSendThreadCount = 1;
+    pstConfig->ullStreamMaxSize = UDS_STREAM_MAX_SIZE;
+    pstConfig->iStreamPoolChunks = UDS_STREAM_POOL_CHUNKS;
+    initUdsThreadAttr(&pstConfig->stConnAttr, "uds-conn");
+    initUdsThreadAttr(&pstConfig->stRecvAttr, "uds-recv");
+    initUdsThreadAttr(&pstConfig->stSendAttr, "uds-send");
+    initUdsThreadAttr(&pstConfig->stDgramAttr, "uds-dgram");
+    initUdsThreadAttr(&pstConfig->stTimerAttr, "uds-timer");
+}
+
+int addUdsThreadCpu(UDS_THREAD_ATTR *pstAttr, int iCpu)
 {
-    unlink(pchUdsPath);
-    pstUdsServer->iServerSock = createUdsServerSocket(pchUdsPath, iUdsClientCount);
+    if (iCpu < 0 || iCpu >= UDS_MAX_CPUS)
+        return -1;
+    pstAttr->aulCpuMask[iCpu / (8 * sizeof(unsigned long))] |= 1UL << (iCpu % (8 * sizeof(unsigned long)));
+    return 0;
+}
+
+static void onUdsChunkRelease(void *pvArg)
+{
+    resumeUdsReads((UDS_SERVER *)pvArg);
+}
+
+int prepareUdsServer(UDS_SERVER *pstUdsServer, const UDS_SERVER_CONFIG *pstConfig, int iServerSock)
+{
+    if (pstConfig->iMaxClients <= 0 || pstConfig->iRecvThreadCount <= 0 || pstConfig->iSendThreadCount <= 0
+     || pstConfig->iBusyPollUsec < 0 || pstConfig->iIdleTimeoutMsec < 0 || pstConfig->iSendStallMsec < 0
+     || pstConfig->iHeartbeatMsec < 0
+     || (pstConfig->iHeartbeatMsec > 0 && (pstConfig->pvHeartbeatData == NULL || pstConfig->iHeartbeatSize <= 0)))
+        return -1;
+
+    if (iServerSock < 0) {
+        unlink(pstConfig->pchUdsPath);
+        iServerSock = createUdsServerSocket(pstConfig->pchUdsPath, pstConfig->iMaxClients);
+    }
+    pstUdsServer->stConfig = *pstConfig;
+    pstUdsServer->iServerSock = iServerSock;
     pthread_mutex_init(&pstUdsServer->mutex, NULL);
-    pstUdsServer->iMaxClients = iUdsClientCount;
+    pthread_cond_init(&pstUdsServer->stDgramCond, NULL);
+    pstUdsServer->iDgramWaiters = 0;
+    pstUdsServer->ulDgramSeq = 0;
+    initUdsDgramPool(&pstUdsServer->stDgramPool, UDS_DGRAM_QUEUE_SIZE);
+    pstUdsServer->iHandingOff = 0;
+    pstUdsServer->iApiCallers = 0;
+    pstUdsServer->iReadPaused = 0;
+    initUdsChunkPool(&pstUdsServer->stChunkPool, pstConfig->iStreamPoolChunks);
+    pstUdsServer->stChunkPool.pfnRelease = onUdsChunkRelease;
+    pstUdsServer->stChunkPool.pvReleaseArg = pstUdsServer;
+    initUdsTimerWheel(&pstUdsServer->stTimerWheel);
+    pstUdsServer->iMaxClients = pstConfig->iMaxClients;
     pstUdsServer->iRunning = 0;
     pstUdsServer->iClientCount = 0;
-    pstUdsServer->pstClients = (CLIENT *)malloc(sizeof(CLIENT) * iUdsClientCount);
+    pstUdsServer->iDgramSock = -1;
+    pstUdsServer->pstThreads = NULL;
+    pstUdsServer->iThreadCount = 0;
+    pstUdsServer->pstRecvThreads = NULL;
+    pstUdsServer->pstSendThreads = NULL;
+    pstUdsServer->pstClients = (CLIENT *)malloc(sizeof(CLIENT) * pstConfig->iMaxClients);
     for (int i = 0; i < pstUdsServer->iMaxClients; ++i) {
         pstUdsServer->pstClients[i].iSock = -1;
         pstUdsServer->pstClients[i].iActive = 0;
         pstUdsServer->pstClients[i].iId = -1;
+        pstUdsServer->pstClients[i].iCoalesceMaxBytes = 0;
+        pstUdsServer->pstClients[i].iCoalesceDelayUsec = 0;
+        pstUdsServer->pstClients[i].pchCoalesceBuf = NULL;
+        pstUdsServer->pstClients[i].iCoalesceLen = 0;
+        memset(&pstUdsServer->pstClients[i].stStreamRx, 0, sizeof(UDS_STREAM_RX));
+        pthread_cond_init(&pstUdsServer->pstClients[i].stRecvCond, NULL);
+        pstUdsServer->pstClients[i].iRecvWaiters = 0;
+        pstUdsServer->pstClients[i].ulRecvSeq = 0;
+        pstUdsServer->pstClients[i].ullRecvQueuedBytes = 0;
+        pstUdsServer->pstClients[i].ullSendQueuedBytes = 0;
+        pstUdsServer->pstClients[i].uiGeneration = 0;
+        pstUdsServer->pstClients[i].ullSendMpscBytes = 0;
+        pstUdsServer->pstClients[i].ullChunkBytes = 0;
+        pstUdsServer->pstClients[i].iEvicted = 0;
+        pstUdsServer->pstClients[i].ulSendSeq = 0;
+        initUdsMpscQueue(&pstUdsServer->pstClients[i].stSendMpsc);
+        initUdsClientTimers(pstUdsServer, i);
     }
+    memset(&pstUdsServer->stStats, 0, sizeof(UDS_SERVER_STATS));
+
+    pstUdsServer->stCapture.pchBase = NULL;
+    if (pstConfig->pchCapturePath != NULL
+     && openUdsCapture(&pstUdsServer->stCapture, pstConfig->pchCapturePath, pstConfig->ullCaptureMaxBytes) != 0)
+        fprintf(stderr, "[Capture] Cannot capture to %s, continuing without capture\n", pstConfig->pchCapturePath);
+
+    if (pstConfig->pchDgramPath != NULL) {
+        pstUdsServer->iDgramSock = createUdsDgramServerSocket(pstConfig->pchDgramPath);
+        if (pstUdsServer->iDgramSock >= 0)
+            queueInit(&pstUdsServer->stDgramQueue, UDS_DGRAM_QUEUE_SIZE);
+    }
+    return 0;
 }
 
-void stopUdsServer(UDS_SERVER *pstUdsServer) 
+int launchUdsServerThreads(UDS_SERVER *pstUdsServer)
+{
+    const UDS_SERVER_CONFIG *pstConfig = &pstUdsServer->stConfig;
+    int iUseTimers = pstConfig->iIdleTimeoutMsec > 0 || pstConfig->iHeartbeatMsec > 0 || pstConfig->iSendStallMsec > 0;
+    int iTotal = 1 + pstConfig->iRecvThreadCount + pstConfig->iSendThreadCount + (pstUdsServer->iDgramSock >= 0) + iUseTimers;
+
+    pstUdsServer->iRunning = 1;
+    pstUdsServer->iThreadCount = 0;
+    pstUdsServer->pstRecvThreads = NULL;
+    pstUdsServer->pstSendThreads = NULL;
+    pstUdsServer->pstThreads = (UDS_SERVER_THREAD *)calloc(iTotal, sizeof(UDS_SERVER_THREAD));
+    if (pstUdsServer->pstThreads == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        stopUdsServer(pstUdsServer);
+        return -1;
+    }
+
+    if (spawnUdsThreads(pstUdsServer, connectionManagerThread, &pstConfig->stConnAttr, 1) != 0
+     || spawnUdsThreads(pstUdsServer, recvThread, &pstConfig->stRecvAttr, pstConfig->iRecvThreadCount) != 0
+     || spawnUdsThreads(pstUdsServer, sendThread, &pstConfig->stSendAttr, pstConfig->iSendThreadCount) != 0
+     || (pstUdsServer->iDgramSock >= 0
+         && spawnUdsThreads(pstUdsServer, dgramRecvThread, &pstConfig->stDgramAttr, 1) != 0)
+     || (iUseTimers && spawnUdsThreads(pstUdsServer, timerThread, &pstConfig->stTimerAttr, 1) != 0)) {
+        stopUdsServer(pstUdsServer);
+        return -1;
+    }
+    return 0;
+}
+
+int startUdsServerWithConfig(UDS_SERVER *pstUdsServer, const UDS_SERVER_CONFIG *pstConfig)
+{
+    if (prepareUdsServer(pstUdsServer, pstConfig, -1) != 0)
+        return -1;
+    return launchUdsServerThreads(pstUdsServer);
+}
+
+void startUdsServer(UDS_SERVER *pstUdsServer, char* pchUdsPath, int iUdsClientCount) 
+{
+    UDS_SERVER_CONFIG stConfig;
+    initUdsServerConfig(&stConfig, pchUdsPath, iUdsClientCount);
+    startUdsServerWithConfig(pstUdsServer, &stConfig);
+}
+
+void haltUdsServerThreads(UDS_SERVER *pstUdsServer)
 {
     pstUdsServer->iRunning = 0;
+    for (int i = 0; i < pstUdsServer->iThreadCount; ++i)
+        wakeUdsThread(&pstUdsServer->pstThreads[i]);
+    wakeUdsTimerWheel(&pstUdsServer->stTimerWheel);
+
+    for (int i = 0; i < pstUdsServer->iThreadCount; ++i) {
+        UDS_SERVER_THREAD *pstThread = &pstUdsServer->pstThreads[i];
+        if (pstThread->iStarted)
+            pthread_join(pstThread->stThread, NULL);
+        for (int j = 0; j < 2; ++j) {
+            if (pstThread->aiWakeFd[j] >= 0)
+                close(pstThread->aiWakeFd[j]);
+        }
+    }
+    free(pstUdsServer->pstThreads);
+    pstUdsServer->pstThreads = NULL;
+    pstUdsServer->iThreadCount = 0;
+    pstUdsServer->pstRecvThreads = NULL;
+    pstUdsServer->pstSendThreads = NULL;
+}
+
+void destroyUdsServer(UDS_SERVER *pstUdsServer)
+{
+    pthread_mutex_lock(&pstUdsServer->mutex);
+    for (int i = 0; i < pstUdsServer->iMaxClients; ++i) {
+        if (pstUdsServer->pstClients[i].iActive)
+            releaseUdsClient(pstUdsServer, i);
+        // 해제 뒤에 늦게 들어온 메시지도 정리한다
+        discardUdsSendMsgs(pstUdsServer, i);
+        pthread_cond_destroy(&pstUdsServer->pstClients[i].stRecvCond);
+    }
     pstUdsServer->iClientCount = 0;
-    
+    pthread_mutex_unlock(&pstUdsServer->mutex);
+
     if (pstUdsServer->iServerSock) {
         udsClose(pstUdsServer->iServerSock);
     }
+    if (pstUdsServer->iDgramSock >= 0) {
+        udsClose(pstUdsServer->iDgramSock);
+        pstUdsServer->iDgramSock = -1;
+        discardUdsDgramMsgs(pstUdsServer);
+        queueDestroy(&pstUdsServer->stDgramQueue);
+    }
+    destroyUdsDgramPool(&pstUdsServer->stDgramPool);
+    pthread_cond_destroy(&pstUdsServer->stDgramCond);
     free(pstUdsServer->pstClients);
-}
\ No newline at end of file
+    pstUdsServer->pstClients = NULL;
+    destroyUdsChunkPool(&pstUdsServer->stChunkPool);
+    destroyUdsTimerWheel(&pstUdsServer->stTimerWheel);
+    closeUdsCapture(&pstUdsServer->stCapture);
+    pthread_mutex_destroy(&pstUdsServer->mutex);
+}
+
+void stopUdsServer(UDS_SERVER *pstUdsServer) 
+{
+    pstUdsServer->iRunning = 0;
+
+    // 블로킹 중인 recvmmsg()를 깨운다. 연결 관리 스레드는 wake 파이프로 깨우므로
+    // 리스닝 소켓은 끊지 않는다 (끊으면 깨어난 accept()가 EINVAL로 실패한다)
+    if (pstUdsServer->iDgramSock >= 0)
+        shutdown(pstUdsServer->iDgramSock, SHUT_RDWR);
+    haltUdsServerThreads(pstUdsServer);
+    destroyUdsServer(pstUdsServer);
+}
+
+void activateUdsClient(UDS_SERVER *pstUdsServer, int iClientIndex, int iClientFd)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+
+    pstClient->iSock = iClientFd;
+    queueInit(&(pstClient->stRecvQueue), 10);
+    queueInit(&(pstClient->stSendQueue), 10);
+    pstClient->iCoalesceMaxBytes = 0;
+    pstClient->iCoalesceLen = 0;
+    pstClient->iEvicted = 0;
+    memset(&pstClient->stStreamRx, 0, sizeof(UDS_STREAM_RX));
+    // 세대를 먼저 올려야 활성화를 본 생산자가 이전 핸들을 통과시키지 않는다
+    unsigned int uiGeneration = pstClient->uiGeneration + 1;
+    __atomic_store_n(&pstClient->uiGeneration, uiGeneration ? uiGeneration : 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&pstClient->iActive, 1, __ATOMIC_RELEASE);
+    startUdsClientTimers(pstUdsServer, iClientIndex);
+    captureUdsRecord(&pstUdsServer->stCapture, UDS_CAPTURE_OPEN, iClientIndex, NULL, 0);
+    pstUdsServer->iClientCount++;
+    pstUdsServer->stStats.ullAccepts++;
+}
+
+void releaseUdsClient(UDS_SERVER *pstUdsServer, int iClientIndex)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+
+    // 만료 콜백이 닫힌(또는 재사용된) fd를 shutdown()하지 않도록 먼저 취소한다
+    stopUdsClientTimers(pstUdsServer, iClientIndex);
+    captureUdsRecord(&pstUdsServer->stCapture, UDS_CAPTURE_CLOSE, iClientIndex, NULL, 0);
+    close(pstClient->iSock);
+    __atomic_store_n(&pstClient->iActive, 0, __ATOMIC_RELEASE);
+    discardUdsSendMsgs(pstUdsServer, iClientIndex);
+    if (pstUdsServer->stConfig.iStreamMode) {
+        // 큐에 남은 스트림 메시지는 청크를 풀로 돌려주도록 참조를 해제한다
+        void *pvData = NULL;
+        abortUdsStreamRx(&pstClient->stStreamRx);
+        while (queuePop(&(pstClient->stRecvQueue), &pvData) > 0 && pvData != NULL)
+            udsStreamMsgRelease((UDS_STREAM_MSG *)pvData);
+    }
+    queueDestroy(&(pstClient->stSendQueue));
+    queueDestroy(&(pstClient->stRecvQueue));
+    __atomic_sub_fetch(&pstUdsServer->stStats.ullQueuedBytes,
+                       pstClient->ullRecvQueuedBytes + pstClient->ullSendQueuedBytes, __ATOMIC_RELAXED);
+    pstClient->ullRecvQueuedBytes = 0;
+    pstClient->ullSendQueuedBytes = 0;
+    resumeUdsReads(pstUdsServer);
+    // 이 슬롯에서 기다리던 소비자가 타임아웃까지 기다리지 않고 끊김을 보도록 깨운다
+    if (pstClient->iRecvWaiters > 0)
+        pthread_cond_broadcast(&pstClient->stRecvCond);
+    free(pstClient->pchCoalesceBuf);
+    pstClient->pchCoalesceBuf = NULL;
+    pstClient->iCoalesceMaxBytes = 0;
+    pstClient->iCoalesceLen = 0;
+    pstClient->iSock = -1;
+    pstUdsServer->iClientCount--;
+    pstUdsServer->stStats.ullReleases++;
+}
+
+void wakeUdsRecvThread(UDS_SERVER *pstUdsServer, int iClientIndex)
+{
+    if (pstUdsServer->pstRecvThreads == NULL)
+        return;
+    wakeUdsThread(&pstUdsServer->pstRecvThreads[iClientIndex % pstUdsServer->stConfig.iRecvThreadCount]);
+}
+
+void wakeUdsSendThread(UDS_SERVER *pstUdsServer, int iClientIndex)
+{
+    if (pstUdsServer->pstSendThreads == NULL)
+        return;
+    UDS_SERVER_THREAD *pstThread = &pstUdsServer->pstSendThreads[iClientIndex % pstUdsServer->stConfig.iSendThreadCount];
+    if (__atomic_load_n(&pstThread->iSleeping, __ATOMIC_SEQ_CST))
+        wakeUdsThread(pstThread);
+}
+
+void signalUdsRecv(UDS_SERVER *pstUdsServer, int iClientIndex)
+{
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+
+    // 메시지 하나에 소비자 하나면 충분하고, 다른 슬롯의 소비자는 깨우지 않는다
+    __atomic_add_fetch(&pstClient->ulRecvSeq, 1, __ATOMIC_RELEASE);
+    if (pstClient->iRecvWaiters > 0)
+        pthread_cond_signal(&pstClient->stRecvCond);
+}
+
+int enterUdsServerApi(UDS_SERVER *pstUdsServer)
+{
+    // 핸드오프 쪽은 플래그를 세운 뒤 호출 수를 읽으므로, 둘 중 하나는 반드시 상대를 본다
+    __atomic_add_fetch(&pstUdsServer->iApiCallers, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pstUdsServer->iHandingOff, __ATOMIC_SEQ_CST)) {
+        leaveUdsServerApi(pstUdsServer);
+        return UDS_HANDING_OFF;
+    }
+    return 0;
+}
+
+void leaveUdsServerApi(UDS_SERVER *pstUdsServer)
+{
+    __atomic_sub_fetch(&pstUdsServer->iApiCallers, 1, __ATOMIC_RELEASE);
+}
+
+unsigned long long getUdsMonotonicUsec(void)
+{
+    struct timespec stNow;
+    clock_gettime(CLOCK_MONOTONIC, &stNow);
+    return (unsigned long long)stNow.tv_sec * 1000000ULL + stNow.tv_nsec / 1000;
+}
+
+void udsCpuRelax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#else
+    sched_yield();
+#endif
+}
+
+int udsServerRecv(UDS_SERVER *pstUdsServer, int iClientIndex, void **ppvData, int iTimeoutMsec)
+{
+    CLIENT *pstClient;
+    int iSize = 0;
+
+    *ppvData = NULL;
+    if (enterUdsServerApi(pstUdsServer) != 0)
+        return UDS_HANDING_OFF;
+    if (iClientIndex < 0 || iClientIndex >= pstUdsServer->iMaxClients) {
+        leaveUdsServerApi(pstUdsServer);
+        return -1;
+    }
+    pstClient = &pstUdsServer->pstClients[iClientIndex];
+
+    unsigned long long ullStartUsec = getUdsMonotonicUsec();
+    unsigned long long ullSpinEndUsec = ullStartUsec + pstUdsServer->stConfig.iBusyPollUsec;
+    unsigned long long ullEndUsec = ullStartUsec + (unsigned long long)iTimeoutMsec * 1000ULL;
+    if (ullSpinEndUsec > ullEndUsec)
+        ullSpinEndUsec = ullEndUsec;
+
+    pthread_mutex_lock(&pstUdsServer->mutex);
+    while (pstClient->iActive && (iSize = queuePop(&pstClient->stRecvQueue, ppvData)) <= 0) {
+        unsigned long long ullNowUsec = getUdsMonotonicUsec();
+        if (ullNowUsec >= ullEndUsec || pstUdsServer->iHandingOff)
+            break;
+        if (ullNowUsec < ullSpinEndUsec) {
+            // 바쁜 대기 구간: 뮤텍스를 놓고 수신 순번이 바뀔 때까지만 확인한다
+            unsigned long ulSeq = __atomic_load_n(&pstClient->ulRecvSeq, __ATOMIC_ACQUIRE);
+            pthread_mutex_unlock(&pstUdsServer->mutex);
+            while (__atomic_load_n(&pstClient->ulRecvSeq, __ATOMIC_ACQUIRE) == ulSeq
+                && getUdsMonotonicUsec() < ullSpinEndUsec)
+                udsCpuRelax();
+            pthread_mutex_lock(&pstUdsServer->mutex);
+            continue;
+        }
+        struct timespec stDeadline;
+        clock_gettime(CLOCK_REALTIME, &stDeadline);
+        unsigned long long ullNsec = stDeadline.tv_nsec + (ullEndUsec - ullNowUsec) * 1000ULL;
+        stDeadline.tv_sec += ullNsec / 1000000000ULL;
+        stDeadline.tv_nsec = ullNsec % 1000000000ULL;
+        pstClient->iRecvWaiters++;
+        pthread_cond_timedwait(&pstClient->stRecvCond, &pstUdsServer->mutex, &stDeadline);
+        pstClient->iRecvWaiters--;
+    }
+    if (iSize > 0)
+        releaseUdsMemory(pstUdsServer, iClientIndex, UDS_QUEUE_RECV, iSize);
+    int iActive = pstClient->iActive;
+    int iHandingOff = pstUdsServer->iHandingOff;
+    pthread_mutex_unlock(&pstUdsServer->mutex);
+    leaveUdsServerApi(pstUdsServer);
+
+    if (iSize > 0)
+        return iSize;
+    if (iHandingOff)
+        return UDS_HANDING_OFF;
+    return iActive ? UDS_TIME_OUT : -1;
+}
+
+int setUdsClientCoalescing(UDS_SERVER *pstUdsServer, int iClientIndex, int iMaxBytes, int iDelayUsec)
+{
+    int iRet = -1;
+
+    if (iClientIndex < 0 || iClientIndex >= pstUdsServer->iMaxClients || iMaxBytes < 0 || iDelayUsec < 0)
+        return -1;
+    if (enterUdsServerApi(pstUdsServer) != 0)
+        return UDS_HANDING_OFF;
+
+    pthread_mutex_lock(&pstUdsServer->mutex);
+    CLIENT *pstClient = &pstUdsServer->pstClients[iClientIndex];
+    if (pstClient->iActive) {
+        if (pstClient->iCoalesceLen > 0) {
+            udsSendMsg(pstClient->iSock, pstClient->pchCoalesceBuf, pstClient->iCoalesceLen);
+            pstClient->iCoalesceLen = 0;
+        }
+        char *pchBuf = NULL;
+        if (iMaxBytes > 0)
+            pchBuf = (char *)realloc(pstClient->pchCoalesceBuf, iMaxBytes);
+        if (iMaxBytes == 0 || pchBuf != NULL) {
+            if (iMaxBytes == 0)
+                free(pstClient->pchCoalesceBuf);
+            pstClient->pchCoalesceBuf = pchBuf;
+            pstClient->iCoalesceMaxBytes = iMaxBytes;
+            pstClient->iCoalesceDelayUsec = iDelayUsec;
+            signalUdsSend(pstUdsServer, iClientIndex);
+            iRet = 0;
+        }
+    }
+    pthread_mutex_unlock(&pstUdsServer->mutex);
+    leaveUdsServerApi(pstUdsServer);
+    return iRet;
+}
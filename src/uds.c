@@ -1,4 +1,5 @@
 #include "uds.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -38,6 +39,56 @@ int createUdsServerSocket(const char *pchSocketPath, int iMaxClients) {
     return iServerFd;
 }
 
+int createUdsDgramServerSocket(const char *pchSocketPath)
+{
+    int iSock;
+    int iOn = 1;
+    struct sockaddr_un address;
+
+    if ((iSock = socket(AF_UNIX, SOCK_DGRAM, 0)) == -1) {
+        perror("Dgram socket failed");
+        return -1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, pchSocketPath, sizeof(address.sun_path) - 1);
+    unlink(pchSocketPath);
+
+    if (bind(iSock, (struct sockaddr *)&address, sizeof(address)) == -1) {
+        perror("Dgram bind failed");
+        close(iSock);
+        return -1;
+    }
+
+    if (setsockopt(iSock, SOL_SOCKET, SO_PASSCRED, &iOn, sizeof(iOn)) == -1) {
+        perror("SO_PASSCRED failed");
+    }
+    return iSock;
+}
+
+int createUdsDgramClientSocket(const char *pchSocketPath)
+{
+    int iSock;
+    struct sockaddr_un address;
+
+    if ((iSock = socket(AF_UNIX, SOCK_DGRAM, 0)) == -1) {
+        perror("Dgram socket creation error");
+        return -1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, pchSocketPath, sizeof(address.sun_path) - 1);
+
+    if (connect(iSock, (struct sockaddr *)&address, sizeof(address)) == -1) {
+        perror("Dgram connection failed");
+        close(iSock);
+        return -1;
+    }
+    return iSock;
+}
+
 int acceptUdsClient(int iServerFd) 
 {
     int iClientSockFd;
@@ -80,7 +131,7 @@ void handleUdsClientDisconnection(int iClientSockFd)
 }
 
 int udsSendMsg(int iSock, const char *pchData, size_t iLength) {
-    return send(iSock, pchData, iLength, 0);
+    return send(iSock, pchData, iLength, MSG_NOSIGNAL);
 }
 
 int udsRecvMsg(int iSock, char *pchData, size_t iLength) {
@@ -116,6 +167,96 @@ int udsRecvMsgTimeout(int iSock, char *pchData, size_t iLength, int iTimeoutMsec
 
     return (int)received;
 }
+int udsSendFd(int iSock, const void *pvData, size_t iLength, int iFd)
+{
+    union {
+        char chBuf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr stAlign;
+    } uControl;
+    struct msghdr stMsg;
+    struct iovec stIov;
+    size_t iSent = 0;
+
+    while (iSent < iLength) {
+        memset(&stMsg, 0, sizeof(stMsg));
+        stIov.iov_base = (char *)pvData + iSent;
+        stIov.iov_len = iLength - iSent;
+        stMsg.msg_iov = &stIov;
+        stMsg.msg_iovlen = 1;
+        if (iSent == 0 && iFd >= 0) {
+            // 디스크립터는 첫 바이트와 함께 한 번만 보낸다
+            memset(&uControl, 0, sizeof(uControl));
+            stMsg.msg_control = uControl.chBuf;
+            stMsg.msg_controllen = sizeof(uControl.chBuf);
+            struct cmsghdr *pstCmsg = CMSG_FIRSTHDR(&stMsg);
+            pstCmsg->cmsg_level = SOL_SOCKET;
+            pstCmsg->cmsg_type = SCM_RIGHTS;
+            pstCmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            memcpy(CMSG_DATA(pstCmsg), &iFd, sizeof(int));
+        }
+        ssize_t iRet = sendmsg(iSock, &stMsg, MSG_NOSIGNAL);
+        if (iRet < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("sendmsg failed");
+            return -1;
+        }
+        iSent += iRet;
+    }
+    return (int)iSent;
+}
+
+int udsRecvFd(int iSock, void *pvData, size_t iLength, int *piFd)
+{
+    union {
+        char chBuf[CMSG_SPACE(sizeof(int) * 4)];
+        struct cmsghdr stAlign;
+    } uControl;
+    struct msghdr stMsg;
+    struct iovec stIov;
+    size_t iReceived = 0;
+
+    if (piFd != NULL)
+        *piFd = -1;
+    while (iReceived < iLength) {
+        memset(&stMsg, 0, sizeof(stMsg));
+        stIov.iov_base = (char *)pvData + iReceived;
+        stIov.iov_len = iLength - iReceived;
+        stMsg.msg_iov = &stIov;
+        stMsg.msg_iovlen = 1;
+        stMsg.msg_control = uControl.chBuf;
+        stMsg.msg_controllen = sizeof(uControl.chBuf);
+        ssize_t iRet = recvmsg(iSock, &stMsg, MSG_CMSG_CLOEXEC);
+        if (iRet < 0 && errno == EINTR)
+            continue;
+        if (iRet <= 0)
+            break;
+        for (struct cmsghdr *pstCmsg = CMSG_FIRSTHDR(&stMsg); pstCmsg != NULL; pstCmsg = CMSG_NXTHDR(&stMsg, pstCmsg)) {
+            if (pstCmsg->cmsg_level != SOL_SOCKET || pstCmsg->cmsg_type != SCM_RIGHTS)
+                continue;
+            int iCount = (pstCmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (int i = 0; i < iCount; ++i) {
+                int iFd;
+                memcpy(&iFd, CMSG_DATA(pstCmsg) + i * sizeof(int), sizeof(int));
+                // 요청한 하나 외에 함께 온 디스크립터는 새지 않도록 닫는다
+                if (piFd != NULL && *piFd < 0)
+                    *piFd = iFd;
+                else
+                    close(iFd);
+            }
+        }
+        iReceived += iRet;
+    }
+    if (iReceived < iLength) {
+        if (piFd != NULL && *piFd >= 0) {
+            close(*piFd);
+            *piFd = -1;
+        }
+        return iReceived == 0 ? 0 : -1;
+    }
+    return (int)iReceived;
+}
+
 void udsClose(int iSock) {
     close(iSock);
 }
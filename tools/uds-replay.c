@@ -0,0 +1,554 @@
+/**
+ * @file uds-replay.c
+ * @brief 캡처 로그 재생 부하 생성기
+ *
+ * 서버의 캡처 모드(UDS_SERVER_CONFIG.pchCapturePath)로 기록한 로그를 읽어,
+ * 클라이언트 연결 단위(OPEN~CLOSE)로 같은 데이터를 같은 간격으로 다시 보냅니다.
+ * 데이터그램 레코드는 송신자 PID별로 묶어 -g로 지정한 데이터그램 엔드포인트로 보내며,
+ * -g가 없으면 건너뜁니다. 배속을 지정하거나(-x) 시간 간격을 무시하고 최대 속도로(-F)
+ * 보낼 수 있으며, -n으로 각 연결을 여러 개의 동시 클라이언트로 복제할 수 있습니다.
+ *
+ * 연결마다 스레드를 만들지 않고, 고정 크기(-w) 작업 스레드가 맡은 연결들을 함께 진행합니다.
+ * 각 스레드는 다음 동작 시각 순의 타이머 힙과 poll()로 여러 연결 소켓을 다루므로,
+ * 동시에 열려 있는 연결 수는 작업 스레드 수에 묶이지 않습니다.
+ * 소켓이 가득 차면 그 연결만 쓰기 가능해질 때까지 기다리며, 밀린 시간은 max lag에 나타납니다.
+ *
+ * 사용법: uds-replay -f <캡처 파일> -s <서버 소켓 경로> [-g 데이터그램 경로] [-x 배속] [-F]
+ *                    [-n 복제 수] [-w 작업 스레드 수]
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "uds.h"
+#include "uds-capture.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#define REPLAY_DEFAULT_WORKERS  4   ///< 기본 작업 스레드 수
+
+#define REPLAY_STEP_SCHEDULED   0   ///< 다음 레코드 시각에 다시 진행
+#define REPLAY_STEP_BLOCKED     1   ///< 소켓이 쓰기 가능해질 때까지 대기
+#define REPLAY_STEP_DONE        2   ///< 연결 재생 종료
+
+/**
+ * @brief 캡처된 연결 하나 (같은 클라이언트 ID의 OPEN부터 CLOSE까지, 또는 같은 PID의 데이터그램)
+ */
+typedef struct {
+    unsigned int uiClientId;        ///< 캡처 당시 슬롯 인덱스 (데이터그램은 송신자 PID)
+    int iDgram;                     ///< 데이터그램 레코드 묶음이면 1
+    unsigned long long ullOpenNsec; ///< 연결 시각 (데이터그램은 첫 레코드 시각)
+    size_t *piOffsets;              ///< DATA/CLOSE/DGRAM 레코드 위치 목록
+    int iCount;                     ///< 레코드 수
+    int iCapacity;                  ///< 목록 용량
+} REPLAY_SESSION;
+
+/**
+ * @brief 작업 스레드가 함께 쓰는 재생 입력
+ */
+typedef struct {
+    const UDS_CAPTURE_LOG *pstLog;
+    const REPLAY_SESSION *pstSessions; ///< 시작 시각 순으로 정렬된 연결 목록
+    int iJobCount;                  ///< 연결 수 x 복제 수
+    int iCopies;                    ///< 연결별 복제 수
+    int iWorkers;                   ///< 작업 스레드 수 (작업 j는 j % iWorkers 번 스레드가 맡음)
+    const char *pchSocketPath;
+    const char *pchDgramPath;       ///< 데이터그램 엔드포인트 경로 (NULL이면 데이터그램 생략)
+    double dSpeed;                  ///< 배속 (0이면 최대 속도)
+    unsigned long long ullBaseNsec; ///< 재생 시작 단조 시각
+} REPLAY_CONTEXT;
+
+/**
+ * @brief 재생 중인 연결 하나의 진행 상태
+ */
+typedef struct {
+    const REPLAY_SESSION *pstSession;
+    int iSock;                      ///< 연결 소켓 (열기 전이면 -1)
+    int iNext;                      ///< 다음에 보낼 레코드 번호
+    unsigned int uiSent;            ///< 다음 레코드 중 이미 보낸 바이트 수 (스트림 소켓의 부분 전송)
+    unsigned long long ullDueNsec;  ///< 다음 동작 예정 단조 시각
+} REPLAY_STATE;
+
+/**
+ * @brief 작업 스레드 하나의 결과
+ */
+typedef struct {
+    pthread_t stThread;
+    REPLAY_CONTEXT *pstContext;
+    int iIndex;                     ///< 작업 스레드 번호
+    int iSessions;                  ///< 재생한 연결 수
+    unsigned long long ullMessages; ///< 보낸 메시지 수
+    unsigned long long ullBytes;    ///< 보낸 바이트 수
+    unsigned long long ullMaxLagNsec; ///< 예정 시각보다 늦게 보낸 최대 시간
+    int iFailed;                    ///< 연결 또는 전송에 실패한 연결 수
+} REPLAY_WORKER;
+
+static unsigned long long getReplayNsec(void)
+{
+    struct timespec stNow;
+    clock_gettime(CLOCK_MONOTONIC, &stNow);
+    return (unsigned long long)stNow.tv_sec * 1000000000ULL + stNow.tv_nsec;
+}
+
+/**
+ * @brief 캡처 시각에 해당하는 재생 단조 시각 (최대 속도면 0으로 바로 진행)
+ */
+static unsigned long long getReplayDueNsec(const REPLAY_CONTEXT *pstContext, unsigned long long ullCaptureNsec)
+{
+    if (pstContext->dSpeed <= 0)
+        return 0;
+    return pstContext->ullBaseNsec + (unsigned long long)(ullCaptureNsec / pstContext->dSpeed);
+}
+
+static const UDS_CAPTURE_RECORD* getReplayRecord(const REPLAY_CONTEXT *pstContext, const REPLAY_SESSION *pstSession, int iIndex)
+{
+    size_t iOffset = pstSession->piOffsets[iIndex];
+    return nextUdsCaptureRecord(pstContext->pstLog, &iOffset);
+}
+
+/**
+ * @brief 다음 동작 시각이 가장 이른 연결이 맨 앞에 오는 최소 힙
+ */
+static void pushReplayHeap(REPLAY_STATE **ppstHeap, int *piCount, REPLAY_STATE *pstState)
+{
+    int i = (*piCount)++;
+
+    while (i > 0 && ppstHeap[(i - 1) / 2]->ullDueNsec > pstState->ullDueNsec) {
+        ppstHeap[i] = ppstHeap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    ppstHeap[i] = pstState;
+}
+
+static REPLAY_STATE* popReplayHeap(REPLAY_STATE **ppstHeap, int *piCount)
+{
+    REPLAY_STATE *pstTop = ppstHeap[0];
+    REPLAY_STATE *pstLast = ppstHeap[--(*piCount)];
+    int i = 0;
+
+    for (;;) {
+        int iChild = i * 2 + 1;
+        if (iChild >= *piCount)
+            break;
+        if (iChild + 1 < *piCount && ppstHeap[iChild + 1]->ullDueNsec < ppstHeap[iChild]->ullDueNsec)
+            iChild++;
+        if (ppstHeap[iChild]->ullDueNsec >= pstLast->ullDueNsec)
+            break;
+        ppstHeap[i] = ppstHeap[iChild];
+        i = iChild;
+    }
+    if (*piCount > 0)
+        ppstHeap[i] = pstLast;
+    return pstTop;
+}
+
+static void finishReplayState(REPLAY_WORKER *pstWorker, REPLAY_STATE *pstState)
+{
+    if (pstState->iSock > 0)
+        udsClose(pstState->iSock);
+    pstState->iSock = -1;
+    pstWorker->iSessions++;
+}
+
+/**
+ * @brief 예정 시각이 된 연결을 한 단계 진행 (연결을 열거나 레코드 하나를 보냄)
+ *
+ * 소켓은 MSG_DONTWAIT로 보내므로 한 연결이 막혀도 같은 스레드의 다른 연결은 계속 진행된다.
+ *
+ * @return REPLAY_STEP_SCHEDULED, REPLAY_STEP_BLOCKED, REPLAY_STEP_DONE 중 하나
+ */
+static int stepReplayState(REPLAY_WORKER *pstWorker, REPLAY_STATE *pstState, unsigned long long ullNowNsec)
+{
+    const REPLAY_CONTEXT *pstContext = pstWorker->pstContext;
+    const REPLAY_SESSION *pstSession = pstState->pstSession;
+
+    if (pstState->iSock < 0) {
+        pstState->iSock = pstSession->iDgram ? createUdsDgramClientSocket(pstContext->pchDgramPath)
+                                             : createUdsClientSocket(pstContext->pchSocketPath);
+        if (pstState->iSock <= 0) {
+            pstWorker->iFailed++;
+            finishReplayState(pstWorker, pstState);
+            return REPLAY_STEP_DONE;
+        }
+    } else {
+        const UDS_CAPTURE_RECORD *pstRecord = getReplayRecord(pstContext, pstSession, pstState->iNext);
+        if (pstState->uiSent == 0 && pstContext->dSpeed > 0 && ullNowNsec - pstState->ullDueNsec > pstWorker->ullMaxLagNsec)
+            pstWorker->ullMaxLagNsec = ullNowNsec - pstState->ullDueNsec;
+        if (pstRecord->uiType == UDS_CAPTURE_CLOSE) {
+            finishReplayState(pstWorker, pstState);
+            return REPLAY_STEP_DONE;
+        }
+        ssize_t iSent = send(pstState->iSock, UDS_CAPTURE_PAYLOAD(pstRecord) + pstState->uiSent,
+                             pstRecord->uiLength - pstState->uiSent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (iSent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            return REPLAY_STEP_BLOCKED;
+        if (iSent < 0) {
+            pstWorker->iFailed++;
+            finishReplayState(pstWorker, pstState);
+            return REPLAY_STEP_DONE;
+        }
+        pstState->uiSent += (unsigned int)iSent;
+        if (pstState->uiSent < pstRecord->uiLength)
+            return REPLAY_STEP_BLOCKED;
+        pstState->uiSent = 0;
+        pstState->iNext++;
+        pstWorker->ullMessages++;
+        pstWorker->ullBytes += pstRecord->uiLength;
+    }
+
+    if (pstState->iNext >= pstSession->iCount) {
+        finishReplayState(pstWorker, pstState);
+        return REPLAY_STEP_DONE;
+    }
+    pstState->ullDueNsec = getReplayDueNsec(pstContext, getReplayRecord(pstContext, pstSession, pstState->iNext)->ullTimeNsec);
+    return REPLAY_STEP_SCHEDULED;
+}
+
+/**
+ * @brief 맡은 연결들을 타이머 힙과 poll()로 함께 재생
+ *
+ * 예정 시각이 된 연결을 힙에서 꺼내 진행하고, 소켓이 막힌 연결은 POLLOUT을 기다린다.
+ * 다음 예정 시각까지는 막힌 소켓들을 poll()하며 잠든다.
+ */
+static void* replayThread(void* arg)
+{
+    REPLAY_WORKER *pstWorker = (REPLAY_WORKER *)arg;
+    REPLAY_CONTEXT *pstContext = pstWorker->pstContext;
+    int iStateCount = 0;
+
+    for (int iJob = pstWorker->iIndex; iJob < pstContext->iJobCount; iJob += pstContext->iWorkers)
+        iStateCount++;
+    REPLAY_STATE *pstStates = (REPLAY_STATE *)calloc(iStateCount + 1, sizeof(REPLAY_STATE));
+    REPLAY_STATE **ppstHeap = (REPLAY_STATE **)calloc(iStateCount + 1, sizeof(REPLAY_STATE *));
+    REPLAY_STATE **ppstBlocked = (REPLAY_STATE **)calloc(iStateCount + 1, sizeof(REPLAY_STATE *));
+    struct pollfd *pstPollFds = (struct pollfd *)calloc(iStateCount + 1, sizeof(struct pollfd));
+    if (pstStates == NULL || ppstHeap == NULL || ppstBlocked == NULL || pstPollFds == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        pstWorker->iFailed += iStateCount;
+        iStateCount = 0;
+    }
+
+    // 작업 번호는 시작 시각 순이므로, 스레드마다 번갈아 맡으면 동시에 열리는 연결이 고르게 나뉜다
+    int iHeapCount = 0;
+    int iBlockedCount = 0;
+    for (int i = 0, iJob = pstWorker->iIndex; i < iStateCount; ++i, iJob += pstContext->iWorkers) {
+        REPLAY_STATE *pstState = &pstStates[i];
+        pstState->pstSession = &pstContext->pstSessions[iJob / pstContext->iCopies];
+        pstState->iSock = -1;
+        pstState->ullDueNsec = getReplayDueNsec(pstContext, pstState->pstSession->ullOpenNsec);
+        pushReplayHeap(ppstHeap, &iHeapCount, pstState);
+    }
+
+    while (iHeapCount > 0 || iBlockedCount > 0) {
+        unsigned long long ullNowNsec = getReplayNsec();
+        while (iHeapCount > 0 && ppstHeap[0]->ullDueNsec <= ullNowNsec) {
+            REPLAY_STATE *pstState = popReplayHeap(ppstHeap, &iHeapCount);
+            int iStep = stepReplayState(pstWorker, pstState, ullNowNsec);
+            if (iStep == REPLAY_STEP_SCHEDULED)
+                pushReplayHeap(ppstHeap, &iHeapCount, pstState);
+            else if (iStep == REPLAY_STEP_BLOCKED)
+                ppstBlocked[iBlockedCount++] = pstState;
+            // 최대 속도에서는 예정 시각이 모두 0이라 바로 다음 연결로 넘어간다
+        }
+        if (iHeapCount == 0 && iBlockedCount == 0)
+            break;
+
+        struct timespec stTimeout;
+        struct timespec *pstTimeout = NULL;
+        if (iHeapCount > 0) {
+            unsigned long long ullDueNsec = ppstHeap[0]->ullDueNsec;
+            ullNowNsec = getReplayNsec();
+            unsigned long long ullWaitNsec = ullDueNsec > ullNowNsec ? ullDueNsec - ullNowNsec : 0;
+            stTimeout.tv_sec = ullWaitNsec / 1000000000ULL;
+            stTimeout.tv_nsec = ullWaitNsec % 1000000000ULL;
+            pstTimeout = &stTimeout;
+        }
+        for (int i = 0; i < iBlockedCount; ++i) {
+            pstPollFds[i].fd = ppstBlocked[i]->iSock;
+            pstPollFds[i].events = POLLOUT;
+            pstPollFds[i].revents = 0;
+        }
+        if (ppoll(pstPollFds, iBlockedCount, pstTimeout, NULL) <= 0)
+            continue;
+
+        // 쓰기 가능해진 (또는 끊긴) 연결은 지금 시각으로 힙에 돌려 바로 다시 시도한다
+        int iStillBlocked = 0;
+        ullNowNsec = getReplayNsec();
+        for (int i = 0; i < iBlockedCount; ++i) {
+            if (pstPollFds[i].revents != 0) {
+                ppstBlocked[i]->ullDueNsec = ullNowNsec;
+                pushReplayHeap(ppstHeap, &iHeapCount, ppstBlocked[i]);
+            } else {
+                ppstBlocked[iStillBlocked++] = ppstBlocked[i];
+            }
+        }
+        iBlockedCount = iStillBlocked;
+    }
+
+    free(pstStates);
+    free(ppstHeap);
+    free(ppstBlocked);
+    free(pstPollFds);
+    return NULL;
+}
+
+static int appendReplayOffset(REPLAY_SESSION *pstSession, size_t iOffset)
+{
+    if (pstSession->iCount == pstSession->iCapacity) {
+        int iNewCapacity = pstSession->iCapacity ? pstSession->iCapacity * 2 : 64;
+        size_t *piOffsets = (size_t *)realloc(pstSession->piOffsets, iNewCapacity * sizeof(size_t));
+        if (piOffsets == NULL)
+            return -1;
+        pstSession->piOffsets = piOffsets;
+        pstSession->iCapacity = iNewCapacity;
+    }
+    pstSession->piOffsets[pstSession->iCount++] = iOffset;
+    return 0;
+}
+
+static REPLAY_SESSION* addReplaySession(REPLAY_SESSION **ppstSessions, int *piCount, int *piCapacity,
+                                        const UDS_CAPTURE_RECORD *pstRecord)
+{
+    if (*piCount == *piCapacity) {
+        int iNewCapacity = *piCapacity ? *piCapacity * 2 : 64;
+        REPLAY_SESSION *pstNew = (REPLAY_SESSION *)realloc(*ppstSessions, iNewCapacity * sizeof(REPLAY_SESSION));
+        if (pstNew == NULL)
+            return NULL;
+        *ppstSessions = pstNew;
+        *piCapacity = iNewCapacity;
+    }
+    REPLAY_SESSION *pstSession = &(*ppstSessions)[(*piCount)++];
+    memset(pstSession, 0, sizeof(REPLAY_SESSION));
+    pstSession->uiClientId = pstRecord->uiClientId;
+    pstSession->iDgram = pstRecord->uiType == UDS_CAPTURE_DGRAM;
+    pstSession->ullOpenNsec = pstRecord->ullTimeNsec;
+    return pstSession;
+}
+
+static int compareReplaySessions(const void *pvLeft, const void *pvRight)
+{
+    const REPLAY_SESSION *pstLeft = (const REPLAY_SESSION *)pvLeft;
+    const REPLAY_SESSION *pstRight = (const REPLAY_SESSION *)pvRight;
+
+    if (pstLeft->ullOpenNsec != pstRight->ullOpenNsec)
+        return pstLeft->ullOpenNsec < pstRight->ullOpenNsec ? -1 : 1;
+    return 0;
+}
+
+/**
+ * @brief 로그를 한 번 훑어 연결 단위로 레코드 위치를 모으고 시작 시각 순으로 정렬
+ *
+ * @param iWithDgram 0이면 데이터그램 레코드를 건너뜀
+ * @return 연결 수, 실패 시 -1
+ */
+static int buildReplaySessions(const UDS_CAPTURE_LOG *pstLog, int iWithDgram, REPLAY_SESSION **ppstSessions)
+{
+    REPLAY_SESSION *pstSessions = NULL;
+    int iSessionCount = 0;
+    int iSessionCapacity = 0;
+    int *piCurrent = NULL;          // 클라이언트 ID별 진행 중인 연결 인덱스 (-1이면 없음)
+    unsigned int uiIdCapacity = 0;
+    int *piDgramSessions = NULL;    // 데이터그램 묶음 인덱스 (PID 범위가 넓어 목록으로 찾는다)
+    int iDgramCount = 0;
+    unsigned long long ullSkipped = 0;
+    size_t iOffset = 0;
+    size_t iRecordOffset = 0;
+    const UDS_CAPTURE_RECORD *pstRecord;
+
+    while ((pstRecord = nextUdsCaptureRecord(pstLog, &iOffset)) != NULL) {
+        unsigned int uiId = pstRecord->uiClientId;
+        if (pstRecord->uiType == UDS_CAPTURE_DGRAM) {
+            if (!iWithDgram) {
+                ullSkipped++;
+            } else {
+                int iSession = -1;
+                for (int i = 0; i < iDgramCount && iSession < 0; ++i) {
+                    if (pstSessions[piDgramSessions[i]].uiClientId == uiId)
+                        iSession = piDgramSessions[i];
+                }
+                if (iSession < 0) {
+                    int *piNew = (int *)realloc(piDgramSessions, (iDgramCount + 1) * sizeof(int));
+                    if (piNew == NULL)
+                        goto fail;
+                    piDgramSessions = piNew;
+                    if (addReplaySession(&pstSessions, &iSessionCount, &iSessionCapacity, pstRecord) == NULL)
+                        goto fail;
+                    iSession = piDgramSessions[iDgramCount++] = iSessionCount - 1;
+                }
+                if (appendReplayOffset(&pstSessions[iSession], iRecordOffset) != 0)
+                    goto fail;
+            }
+            iRecordOffset = iOffset;
+            continue;
+        }
+        if (uiId >= uiIdCapacity) {
+            unsigned int uiNewCapacity = uiId + 64;
+            int *piNew = (int *)realloc(piCurrent, uiNewCapacity * sizeof(int));
+            if (piNew == NULL)
+                goto fail;
+            for (unsigned int i = uiIdCapacity; i < uiNewCapacity; ++i)
+                piNew[i] = -1;
+            piCurrent = piNew;
+            uiIdCapacity = uiNewCapacity;
+        }
+
+        // DATA가 OPEN 없이 나오면 (캡처 시작 전에 연결된 클라이언트) 그 시각에 연결한 것으로 본다
+        if (pstRecord->uiType == UDS_CAPTURE_OPEN || (pstRecord->uiType == UDS_CAPTURE_DATA && piCurrent[uiId] < 0)) {
+            if (addReplaySession(&pstSessions, &iSessionCount, &iSessionCapacity, pstRecord) == NULL)
+                goto fail;
+            piCurrent[uiId] = iSessionCount - 1;
+        }
+        if (pstRecord->uiType != UDS_CAPTURE_OPEN && piCurrent[uiId] >= 0) {
+            if (appendReplayOffset(&pstSessions[piCurrent[uiId]], iRecordOffset) != 0)
+                goto fail;
+            if (pstRecord->uiType == UDS_CAPTURE_CLOSE)
+                piCurrent[uiId] = -1;
+        }
+        iRecordOffset = iOffset;
+    }
+    free(piCurrent);
+    free(piDgramSessions);
+    if (ullSkipped > 0)
+        fprintf(stderr, "Skipped %llu datagram records (no -g)\n", ullSkipped);
+    // 레코드는 기록 순서라 여러 수신 스레드가 동시에 쓴 연결은 시각이 살짝 뒤섞일 수 있다
+    if (iSessionCount > 0)
+        qsort(pstSessions, iSessionCount, sizeof(REPLAY_SESSION), compareReplaySessions);
+    *ppstSessions = pstSessions;
+    return iSessionCount;
+
+fail:
+    fprintf(stderr, "Memory allocation failed\n");
+    for (int i = 0; i < iSessionCount; ++i)
+        free(pstSessions[i].piOffsets);
+    free(pstSessions);
+    free(piCurrent);
+    free(piDgramSessions);
+    return -1;
+}
+
+static void printReplayUsage(const char *pchProgram)
+{
+    fprintf(stderr, "Usage: %s -f <capture file> -s <server socket> [-g dgram socket] [-x speed] [-F]\n"
+                    "          [-n copies] [-w workers]\n"
+                    "  -g path    send captured datagrams to this datagram endpoint (skipped if omitted)\n"
+                    "  -x speed   replay N times faster than captured (default 1.0)\n"
+                    "  -F         ignore captured timing and send as fast as possible\n"
+                    "  -n copies  run each captured connection as N concurrent clients (default 1)\n"
+                    "  -w workers number of replay threads (default %d)\n",
+            pchProgram, REPLAY_DEFAULT_WORKERS);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *pchCapturePath = NULL;
+    const char *pchSocketPath = NULL;
+    const char *pchDgramPath = NULL;
+    double dSpeed = 1.0;
+    int iCopies = 1;
+    int iWorkers = REPLAY_DEFAULT_WORKERS;
+    int iOpt;
+
+    while ((iOpt = getopt(argc, argv, "f:s:g:x:Fn:w:h")) != -1) {
+        switch (iOpt) {
+        case 'f': pchCapturePath = optarg; break;
+        case 's': pchSocketPath = optarg; break;
+        case 'g': pchDgramPath = optarg; break;
+        case 'x': dSpeed = atof(optarg); break;
+        case 'F': dSpeed = 0; break;
+        case 'n': iCopies = atoi(optarg); break;
+        case 'w': iWorkers = atoi(optarg); break;
+        default:
+            printReplayUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (pchCapturePath == NULL || pchSocketPath == NULL || iCopies <= 0 || iWorkers <= 0 || dSpeed < 0) {
+        printReplayUsage(argv[0]);
+        return 1;
+    }
+
+    UDS_CAPTURE_LOG stLog;
+    if (openUdsCaptureLog(&stLog, pchCapturePath) != 0)
+        return 1;
+
+    REPLAY_SESSION *pstSessions = NULL;
+    int iSessionCount = buildReplaySessions(&stLog, pchDgramPath != NULL, &pstSessions);
+    if (iSessionCount < 0) {
+        closeUdsCaptureLog(&stLog);
+        return 1;
+    }
+
+    REPLAY_CONTEXT stContext;
+    memset(&stContext, 0, sizeof(stContext));
+    stContext.pstLog = &stLog;
+    stContext.pstSessions = pstSessions;
+    stContext.iJobCount = iSessionCount * iCopies;
+    stContext.iCopies = iCopies;
+    stContext.pchSocketPath = pchSocketPath;
+    stContext.pchDgramPath = pchDgramPath;
+    stContext.dSpeed = dSpeed;
+    if (iWorkers > stContext.iJobCount)
+        iWorkers = stContext.iJobCount > 0 ? stContext.iJobCount : 1;
+    stContext.iWorkers = iWorkers;
+
+    REPLAY_WORKER *pstWorkers = (REPLAY_WORKER *)calloc(iWorkers, sizeof(REPLAY_WORKER));
+    if (pstWorkers == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        closeUdsCaptureLog(&stLog);
+        return 1;
+    }
+
+    // 첫 연결을 기준으로 시작 시각을 맞춰 캡처 앞부분의 빈 시간을 건너뛴다
+    unsigned long long ullFirstNsec = iSessionCount > 0 ? pstSessions[0].ullOpenNsec : 0;
+    unsigned long long ullStartNsec = getReplayNsec();
+    stContext.ullBaseNsec = ullStartNsec - (dSpeed > 0 ? (unsigned long long)(ullFirstNsec / dSpeed) : 0);
+    int iStarted = 0;
+    for (int i = 0; i < iWorkers; ++i) {
+        pstWorkers[i].pstContext = &stContext;
+        pstWorkers[i].iIndex = i;
+        if (pthread_create(&pstWorkers[i].stThread, NULL, replayThread, &pstWorkers[i]) != 0) {
+            perror("Thread create failed");
+            break;
+        }
+        iStarted++;
+    }
+    // 만들지 못한 작업 스레드의 몫은 메인 스레드가 이어서 재생한다 (늦어진 만큼 max lag에 나타난다)
+    for (int i = iStarted; i < iWorkers; ++i)
+        replayThread(&pstWorkers[i]);
+
+    unsigned long long ullMessages = 0, ullBytes = 0, ullMaxLagNsec = 0;
+    int iFailed = 0, iReplayed = 0;
+    for (int i = 0; i < iWorkers; ++i) {
+        if (i < iStarted)
+            pthread_join(pstWorkers[i].stThread, NULL);
+        iReplayed += pstWorkers[i].iSessions;
+        ullMessages += pstWorkers[i].ullMessages;
+        ullBytes += pstWorkers[i].ullBytes;
+        iFailed += pstWorkers[i].iFailed;
+        if (pstWorkers[i].ullMaxLagNsec > ullMaxLagNsec)
+            ullMaxLagNsec = pstWorkers[i].ullMaxLagNsec;
+    }
+    double dElapsed = (getReplayNsec() - ullStartNsec) / 1e9;
+
+    printf("sessions   : %d x %d copies (%d replayed by %d workers, %d failed)\n",
+           iSessionCount, iCopies, iReplayed, iStarted, iFailed);
+    printf("messages   : %llu (%.0f msg/s)\n", ullMessages, dElapsed > 0 ? ullMessages / dElapsed : 0.0);
+    printf("bytes      : %llu (%.2f MB/s)\n", ullBytes, dElapsed > 0 ? ullBytes / dElapsed / 1e6 : 0.0);
+    printf("elapsed    : %.3f s\n", dElapsed);
+    if (dSpeed > 0)
+        printf("max lag    : %.3f ms\n", ullMaxLagNsec / 1e6);
+
+    for (int i = 0; i < iSessionCount; ++i)
+        free(pstSessions[i].piOffsets);
+    free(pstSessions);
+    free(pstWorkers);
+    closeUdsCaptureLog(&stLog);
+    return iFailed > 0 || iReplayed < stContext.iJobCount ? 1 : 0;
+}
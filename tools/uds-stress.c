@@ -0,0 +1,458 @@
+/**
+ * @file uds-stress.c
+ * @brief 연결 churn 및 포화 스트레스 하네스
+ *
+ * 같은 프로세스 안에 서버를 띄우고 여러 스레드가 초당 수천 번씩 연결을 맺고 끊으면서
+ * 일반 종료, 반쪽 종료(shutdown SHUT_WR), 읽지 않은 데이터를 남긴 채 끊기(프로세스 강제 종료와
+ * 같은 경로), 느린 읽기를 섞어 보냅니다. 서버가 받은 데이터는 그대로 돌려보내 송신 경로도 함께 돌립니다.
+ *
+ * 수락률, 반쪽 종료 후 서버가 연결을 닫기까지의 감지 지연, 실행 후 남은 슬롯/fd/큐 집계,
+ * 워밍업 이후 RSS 증가량을 보고하고, 기준을 넘으면 0이 아닌 값으로 종료합니다.
+ *
+ * 사용법: uds-stress [-s 소켓 경로] [-d 초] [-c 슬롯 수] [-t 스레드 수]
+ *                    [-r 최소 수락률/s] [-l 최대 p99 감지 지연 ms] [-m 최대 RSS 증가 KB] [-v]
+ */
+
+#include "uds.h"
+#include "uds-server.h"
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#define STRESS_NORMAL       0       ///< 보내고 바로 닫기
+#define STRESS_HALF_CLOSE   1       ///< 보내고 SHUT_WR 후 서버가 닫을 때까지 대기
+#define STRESS_ABRUPT       2       ///< 돌려받을 데이터를 읽지 않고 닫기
+#define STRESS_SLOW_READER  3       ///< 여러 번 보내고 천천히 읽은 뒤 닫기
+#define STRESS_SCENARIOS    4
+
+#define STRESS_EOF_TIMEOUT_MSEC 2000    ///< 반쪽 종료 후 이 시간 안에 EOF가 오지 않으면 감지 실패
+#define STRESS_HIST_BUCKETS     512     ///< 지연 히스토그램 버킷 수 (옥타브당 8개)
+
+/**
+ * @brief 감지 지연 히스토그램 (us, 로그-선형 버킷)
+ *
+ * 장시간 실행해도 하네스 자신의 메모리가 늘지 않도록 표본을 저장하지 않습니다.
+ */
+typedef struct {
+    unsigned long long aullCount[STRESS_HIST_BUCKETS];
+    unsigned long long ullTotal;
+    unsigned long long ullMaxUsec;
+} STRESS_HIST;
+
+/**
+ * @brief churn 스레드 하나의 결과
+ */
+typedef struct {
+    pthread_t stThread;
+    unsigned int uiSeed;
+    unsigned long long ullConnects;
+    unsigned long long ullConnectFails;
+    unsigned long long aullScenarios[STRESS_SCENARIOS];
+    unsigned long long ullUndetected;   ///< 반쪽 종료 후 EOF를 받지 못한 횟수
+    STRESS_HIST stHist;
+} STRESS_WORKER;
+
+static UDS_SERVER g_stServer;
+static const char *g_pchSocketPath = "/tmp/uds-stress.sock";
+static volatile int g_iStop = 0;
+static unsigned long long g_ullEchoed = 0;
+
+static unsigned long long getStressUsec(void)
+{
+    struct timespec stNow;
+    clock_gettime(CLOCK_MONOTONIC, &stNow);
+    return (unsigned long long)stNow.tv_sec * 1000000ULL + stNow.tv_nsec / 1000;
+}
+
+static int getStressHistBucket(unsigned long long ullUsec)
+{
+    if (ullUsec < 16)
+        return (int)ullUsec;
+    int iOctave = 63 - __builtin_clzll(ullUsec);
+    int iBucket = 16 + (iOctave - 4) * 8 + (int)((ullUsec >> (iOctave - 3)) & 7);
+    return iBucket < STRESS_HIST_BUCKETS ? iBucket : STRESS_HIST_BUCKETS - 1;
+}
+
+static unsigned long long getStressHistUpper(int iBucket)
+{
+    if (iBucket < 16)
+        return iBucket;
+    int iOctave = (iBucket - 16) / 8 + 4;
+    unsigned long long ullStep = 1ULL << (iOctave - 3);
+    return (8 + (iBucket - 16) % 8) * ullStep + ullStep - 1;
+}
+
+static void addStressHist(STRESS_HIST *pstHist, unsigned long long ullUsec)
+{
+    pstHist->aullCount[getStressHistBucket(ullUsec)]++;
+    pstHist->ullTotal++;
+    if (ullUsec > pstHist->ullMaxUsec)
+        pstHist->ullMaxUsec = ullUsec;
+}
+
+static unsigned long long getStressPercentile(const STRESS_HIST *pstHist, double dPercent)
+{
+    unsigned long long ullRank = (unsigned long long)(pstHist->ullTotal * dPercent / 100.0);
+    unsigned long long ullSeen = 0;
+
+    for (int i = 0; i < STRESS_HIST_BUCKETS; ++i) {
+        ullSeen += pstHist->aullCount[i];
+        if (ullSeen > ullRank)
+            return getStressHistUpper(i) < pstHist->ullMaxUsec ? getStressHistUpper(i) : pstHist->ullMaxUsec;
+    }
+    return pstHist->ullMaxUsec;
+}
+
+static int countStressFds(void)
+{
+    int iCount = 0;
+    DIR *pstDir = opendir("/proc/self/fd");
+    struct dirent *pstEntry;
+
+    if (pstDir == NULL)
+        return -1;
+    while ((pstEntry = readdir(pstDir)) != NULL) {
+        if (pstEntry->d_name[0] != '.')
+            iCount++;
+    }
+    closedir(pstDir);
+    return iCount - 1;      // opendir이 연 fd 제외
+}
+
+static long getStressRssKb(void)
+{
+    char chLine[256];
+    long lRssKb = -1;
+    FILE *pstFile = fopen("/proc/self/status", "r");
+
+    if (pstFile == NULL)
+        return -1;
+    while (fgets(chLine, sizeof(chLine), pstFile) != NULL) {
+        if (strncmp(chLine, "VmRSS:", 6) == 0) {
+            lRssKb = strtol(chLine + 6, NULL, 10);
+            break;
+        }
+    }
+    fclose(pstFile);
+    return lRssKb;
+}
+
+/**
+ * @brief 서버가 연결을 닫을 때까지 읽고 버림
+ *
+ * 빈 슬롯이 없어 바로 닫힌 연결은 보낸 데이터가 읽히지 않은 채 닫혀 EOF 대신 ECONNRESET을 받습니다.
+ *
+ * @return EOF나 ECONNRESET을 받으면 1, 시간 초과나 다른 에러면 0
+ */
+static int waitStressEof(int iSock, int iTimeoutMsec)
+{
+    char chBuffer[1024];
+    unsigned long long ullDeadline = getStressUsec() + iTimeoutMsec * 1000ULL;
+    struct pollfd stPollFd;
+
+    stPollFd.fd = iSock;
+    stPollFd.events = POLLIN;
+    while (1) {
+        long long llRemain = (long long)(ullDeadline - getStressUsec());
+        if (llRemain <= 0 || poll(&stPollFd, 1, (int)(llRemain / 1000) + 1) <= 0)
+            return 0;
+        ssize_t iSize = recv(iSock, chBuffer, sizeof(chBuffer), 0);
+        if (iSize == 0 || (iSize < 0 && errno == ECONNRESET))
+            return 1;
+        if (iSize < 0)
+            return 0;
+    }
+}
+
+static int pickStressScenario(unsigned int *puiSeed)
+{
+    int iRoll = rand_r(puiSeed) % 100;
+
+    if (iRoll < 50)
+        return STRESS_NORMAL;
+    if (iRoll < 70)
+        return STRESS_HALF_CLOSE;
+    if (iRoll < 90)
+        return STRESS_ABRUPT;
+    return STRESS_SLOW_READER;
+}
+
+static void* churnThread(void* arg)
+{
+    STRESS_WORKER *pstWorker = (STRESS_WORKER *)arg;
+    static const char chPayload[] = "stress-payload";
+
+    while (!g_iStop) {
+        int iScenario = pickStressScenario(&pstWorker->uiSeed);
+        int iSock = createUdsClientSocket(g_pchSocketPath);
+        if (iSock <= 0) {
+            pstWorker->ullConnectFails++;
+            usleep(1000);
+            continue;
+        }
+        pstWorker->ullConnects++;
+        pstWorker->aullScenarios[iScenario]++;
+
+        switch (iScenario) {
+        case STRESS_NORMAL:
+            udsSendMsg(iSock, chPayload, sizeof(chPayload) - 1);
+            break;
+        case STRESS_HALF_CLOSE: {
+            udsSendMsg(iSock, chPayload, sizeof(chPayload) - 1);
+            unsigned long long ullStart = getStressUsec();
+            shutdown(iSock, SHUT_WR);
+            if (waitStressEof(iSock, STRESS_EOF_TIMEOUT_MSEC))
+                addStressHist(&pstWorker->stHist, getStressUsec() - ullStart);
+            else
+                pstWorker->ullUndetected++;
+            break;
+        }
+        case STRESS_ABRUPT:
+            // 돌려받은 데이터가 소켓에 남은 채 닫히면 서버는 ECONNRESET을 받는다 (강제 종료된 프로세스와 같음)
+            for (int i = 0; i < 3; ++i)
+                udsSendMsg(iSock, chPayload, sizeof(chPayload) - 1);
+            usleep(500);
+            break;
+        case STRESS_SLOW_READER: {
+            char chBuffer[64];
+            for (int i = 0; i < 5; ++i) {
+                udsSendMsg(iSock, chPayload, sizeof(chPayload) - 1);
+                usleep(1000);
+            }
+            for (int i = 0; i < 4; ++i) {
+                usleep(5000);
+                recv(iSock, chBuffer, sizeof(chBuffer), MSG_DONTWAIT);
+            }
+            break;
+        }
+        }
+        udsClose(iSock);
+    }
+    return NULL;
+}
+
+/**
+ * @brief 애플리케이션 역할: 모든 슬롯의 수신 데이터를 그대로 돌려보냄
+ */
+static void* echoThread(void* arg)
+{
+    (void)arg;
+    while (!g_iStop) {
+        int iIdle = 1;
+        for (int i = 0; i < g_stServer.iMaxClients; ++i) {
+            void *pvData = NULL;
+            int iSize;
+            // 슬롯이 그 사이 재사용되면 응답이 새 연결로 가지 않도록 꺼내기 전에 핸들을 얻는다
+            UDS_CLIENT_HANDLE ullHandle = getUdsClientHandle(&g_stServer, i);
+            while ((iSize = udsServerRecv(&g_stServer, i, &pvData, 0)) > 0) {
+                iIdle = 0;
+                if (udsServerSend(&g_stServer, ullHandle, (const char *)pvData, iSize) == 0)
+                    __atomic_add_fetch(&g_ullEchoed, 1, __ATOMIC_RELAXED);
+                free(pvData);
+            }
+        }
+        if (iIdle)
+            usleep(100);
+    }
+    return NULL;
+}
+
+static void printStressUsage(const char *pchProgram)
+{
+    fprintf(stderr, "Usage: %s [-s socket] [-d seconds] [-c slots] [-t threads]\n"
+                    "          [-r min accepts/s] [-l max p99 detect ms] [-m max RSS growth KB] [-v]\n"
+                    "  -s socket   server socket path (default /tmp/uds-stress.sock)\n"
+                    "  -d seconds  run time (default 10)\n"
+                    "  -c slots    server client slots (default 256)\n"
+                    "  -t threads  churn threads (default 8)\n"
+                    "  -r rate     fail if accepts/s is below this (default 1000, 0 disables)\n"
+                    "  -l msec     fail if p99 disconnect detection exceeds this (default 50)\n"
+                    "  -m KB       fail if RSS grows more than this after warm-up (default 4096)\n"
+                    "  -v          keep per-connection server logs on stdout\n",
+            pchProgram);
+}
+
+int main(int argc, char *argv[])
+{
+    int iDurationSec = 10;
+    int iSlots = 256;
+    int iThreadCount = 8;
+    double dMinAcceptRate = 1000;
+    double dMaxDetectMsec = 50;
+    long lMaxRssGrowthKb = 4096;
+    int iVerbose = 0;
+    int iOpt;
+
+    while ((iOpt = getopt(argc, argv, "s:d:c:t:r:l:m:vh")) != -1) {
+        switch (iOpt) {
+        case 's': g_pchSocketPath = optarg; break;
+        case 'd': iDurationSec = atoi(optarg); break;
+        case 'c': iSlots = atoi(optarg); break;
+        case 't': iThreadCount = atoi(optarg); break;
+        case 'r': dMinAcceptRate = atof(optarg); break;
+        case 'l': dMaxDetectMsec = atof(optarg); break;
+        case 'm': lMaxRssGrowthKb = atol(optarg); break;
+        case 'v': iVerbose = 1; break;
+        default:
+            printStressUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (iDurationSec <= 0 || iSlots <= 0 || iThreadCount <= 0) {
+        printStressUsage(argv[0]);
+        return 1;
+    }
+
+    // 서버의 연결마다 찍는 로그는 버리고, 보고서는 원래 stdout으로 쓴다
+    FILE *pstReport = fdopen(dup(STDOUT_FILENO), "w");
+    if (pstReport == NULL) {
+        perror("Report stream failed");
+        return 1;
+    }
+    setvbuf(pstReport, NULL, _IOLBF, 0);
+    if (!iVerbose && freopen("/dev/null", "w", stdout) == NULL)
+        perror("Redirect stdout failed");
+    signal(SIGPIPE, SIG_IGN);
+
+    UDS_SERVER_CONFIG stConfig;
+    initUdsServerConfig(&stConfig, (char *)g_pchSocketPath, iSlots);
+    if (startUdsServerWithConfig(&g_stServer, &stConfig) != 0) {
+        fprintf(stderr, "Server start failed\n");
+        return 1;
+    }
+    pthread_t stEchoThread;
+    if (pthread_create(&stEchoThread, NULL, echoThread, NULL) != 0) {
+        perror("Thread create failed");
+        stopUdsServer(&g_stServer);
+        return 1;
+    }
+    usleep(100 * 1000);
+
+    int iBaseFds = countStressFds();
+    STRESS_WORKER *pstWorkers = (STRESS_WORKER *)calloc(iThreadCount, sizeof(STRESS_WORKER));
+    if (pstWorkers == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
+    int iStarted = 0;
+    for (int i = 0; i < iThreadCount; ++i) {
+        pstWorkers[i].uiSeed = (unsigned int)(getStressUsec() ^ (i * 2654435761u));
+        if (pthread_create(&pstWorkers[i].stThread, NULL, churnThread, &pstWorkers[i]) != 0) {
+            perror("Thread create failed");
+            break;
+        }
+        iStarted++;
+    }
+
+    // 스레드별 malloc 아레나와 풀이 자리잡을 때까지는 RSS 기준점을 잡지 않는다
+    int iWarmupSec = iDurationSec / 10 > 1 ? iDurationSec / 10 : 1;
+    long lBaseRssKb = -1;
+    long lPeakRssKb = 0;
+    unsigned long long ullStartUsec = getStressUsec();
+    UDS_SERVER_STATS stStats;
+    unsigned long long ullLastAccepts = 0;
+    fprintf(pstReport, "%6s %10s %8s %10s %10s\n", "sec", "accepts/s", "clients", "queued", "rss(KB)");
+    for (int iSec = 1; iSec <= iDurationSec; ++iSec) {
+        unsigned long long ullWake = ullStartUsec + iSec * 1000000ULL;
+        unsigned long long ullNow = getStressUsec();
+        if (ullNow < ullWake)
+            usleep(ullWake - ullNow);
+        getUdsServerStats(&g_stServer, &stStats);
+        long lRssKb = getStressRssKb();
+        if (iSec == iWarmupSec)
+            lBaseRssKb = lRssKb;
+        if (lRssKb > lPeakRssKb)
+            lPeakRssKb = lRssKb;
+        fprintf(pstReport, "%6d %10llu %8d %10llu %10ld\n", iSec, stStats.ullAccepts - ullLastAccepts,
+                g_stServer.iClientCount, stStats.ullQueuedBytes, lRssKb);
+        ullLastAccepts = stStats.ullAccepts;
+    }
+    g_iStop = 1;
+    for (int i = 0; i < iStarted; ++i)
+        pthread_join(pstWorkers[i].stThread, NULL);
+    double dElapsed = (getStressUsec() - ullStartUsec) / 1e6;
+
+    // 마지막 연결들이 정리될 때까지 기다린 뒤 남은 자원을 센다
+    for (int i = 0; i < 300 && g_stServer.iClientCount > 0; ++i)
+        usleep(10 * 1000);
+    pthread_join(stEchoThread, NULL);
+    getUdsServerStats(&g_stServer, &stStats);
+    int iLeakedSlots = 0;
+    for (int i = 0; i < g_stServer.iMaxClients; ++i)
+        iLeakedSlots += g_stServer.pstClients[i].iActive ? 1 : 0;
+    int iFdDelta = countStressFds() - iBaseFds;
+    long lFinalRssKb = getStressRssKb();
+    long lRssGrowthKb = lBaseRssKb >= 0 ? lFinalRssKb - lBaseRssKb : 0;
+    stopUdsServer(&g_stServer);
+
+    STRESS_HIST stHist;
+    unsigned long long ullConnects = 0, ullConnectFails = 0, ullUndetected = 0;
+    unsigned long long aullScenarios[STRESS_SCENARIOS] = {0};
+    memset(&stHist, 0, sizeof(stHist));
+    for (int i = 0; i < iStarted; ++i) {
+        ullConnects += pstWorkers[i].ullConnects;
+        ullConnectFails += pstWorkers[i].ullConnectFails;
+        ullUndetected += pstWorkers[i].ullUndetected;
+        for (int j = 0; j < STRESS_SCENARIOS; ++j)
+            aullScenarios[j] += pstWorkers[i].aullScenarios[j];
+        for (int j = 0; j < STRESS_HIST_BUCKETS; ++j)
+            stHist.aullCount[j] += pstWorkers[i].stHist.aullCount[j];
+        stHist.ullTotal += pstWorkers[i].stHist.ullTotal;
+        if (pstWorkers[i].stHist.ullMaxUsec > stHist.ullMaxUsec)
+            stHist.ullMaxUsec = pstWorkers[i].stHist.ullMaxUsec;
+    }
+    free(pstWorkers);
+
+    double dAcceptRate = stStats.ullAccepts / dElapsed;
+    double dP99Msec = getStressPercentile(&stHist, 99) / 1000.0;
+    fprintf(pstReport, "\nconnections : %llu ok, %llu failed (normal %llu, half-close %llu, abrupt %llu, slow %llu)\n",
+            ullConnects, ullConnectFails, aullScenarios[STRESS_NORMAL], aullScenarios[STRESS_HALF_CLOSE],
+            aullScenarios[STRESS_ABRUPT], aullScenarios[STRESS_SLOW_READER]);
+    fprintf(pstReport, "server      : %llu accepted, %llu released, %llu rejected, %llu echoed, %llu stale\n",
+            stStats.ullAccepts, stStats.ullReleases, stStats.ullRejects, g_ullEchoed, stStats.ullStaleSends);
+    fprintf(pstReport, "accept rate : %.0f /s over %.1f s\n", dAcceptRate, dElapsed);
+    fprintf(pstReport, "detect      : p50 %.3f ms, p99 %.3f ms, max %.3f ms, %llu undetected\n",
+            getStressPercentile(&stHist, 50) / 1000.0, dP99Msec, stHist.ullMaxUsec / 1000.0, ullUndetected);
+    fprintf(pstReport, "leaks       : %d slots, %d fds, %llu queued bytes\n", iLeakedSlots, iFdDelta, stStats.ullQueuedBytes);
+    fprintf(pstReport, "rss         : %ld KB after warm-up, %ld KB final, %ld KB peak (%+ld KB)\n",
+            lBaseRssKb, lFinalRssKb, lPeakRssKb, lRssGrowthKb);
+
+    int iFailures = 0;
+    if (dMinAcceptRate > 0 && dAcceptRate < dMinAcceptRate) {
+        fprintf(pstReport, "FAIL: accept rate %.0f /s below %.0f /s\n", dAcceptRate, dMinAcceptRate);
+        iFailures++;
+    }
+    if (ullUndetected > 0 || dP99Msec > dMaxDetectMsec) {
+        fprintf(pstReport, "FAIL: disconnect detection p99 %.3f ms (limit %.3f ms), %llu undetected\n",
+                dP99Msec, dMaxDetectMsec, ullUndetected);
+        iFailures++;
+    }
+    if (iLeakedSlots > 0 || stStats.ullAccepts != stStats.ullReleases) {
+        fprintf(pstReport, "FAIL: %d slots still active, %llu accepts vs %llu releases\n",
+                iLeakedSlots, stStats.ullAccepts, stStats.ullReleases);
+        iFailures++;
+    }
+    if (iFdDelta > 0) {
+        fprintf(pstReport, "FAIL: %d fds leaked\n", iFdDelta);
+        iFailures++;
+    }
+    if (stStats.ullQueuedBytes > 0) {
+        fprintf(pstReport, "FAIL: %llu queued bytes still accounted\n", stStats.ullQueuedBytes);
+        iFailures++;
+    }
+    if (lRssGrowthKb > lMaxRssGrowthKb) {
+        fprintf(pstReport, "FAIL: RSS grew %ld KB after warm-up (limit %ld KB)\n", lRssGrowthKb, lMaxRssGrowthKb);
+        iFailures++;
+    }
+    fprintf(pstReport, "%s\n", iFailures == 0 ? "PASS" : "FAIL");
+    fclose(pstReport);
+    return iFailures == 0 ? 0 : 1;
+}